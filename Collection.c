@@ -3,489 +3,3126 @@
  * Auteurs : Vincent Commin & Louis Leenart
  ********************************************************************/
 
+// fmemopen, open_memstream et pread
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 #include "Collection.h"
 #include "myassert.h"
 
+// taille maximale d'une marque ou d'une immatriculation (limite documentée dans Collection.h)
+#define COL_MAX_LEN 1000
+
 /*----------*
  * définition de la structure
  *----------*/
 
-typedef struct Element
+struct Zone;
+
+// Voiture partagée entre plusieurs collections (copy-on-write).
+// Une voiture n'est modifiée que si une seule collection la référence,
+// elle peut donc être partagée sans copie.
+typedef struct VoiturePartagee
 {
     Voiture voiture;
+    int nbReferences;
+    // zone de col_compacter qui la contient, NULL si elle est allouée seule
+    struct Zone *zone;
+} VoiturePartagee;
+
+typedef struct Element
+{
+    VoiturePartagee *partage;
     struct Element *precedent;
     struct Element *suivant;
 } Element;
 
+// Stockage contigu créé par col_compacter : chaque case regroupe un élément
+// et sa voiture partagée, dans l'ordre de la liste. Les éléments d'une zone
+// appartiennent tous à la même chaîne, qui les retrouve par recherche dichotomique
+// dans son tableau de zones trié par adresse.
+// La zone est libérée quand plus aucun de ses éléments ni de ses voitures n'est utilisé.
+typedef struct Case
+{
+    Element element;
+    VoiturePartagee partage;
+} Case;
+
+typedef struct Zone
+{
+    int nbElements;
+    int nbPartages;
+    int nbCases;
+    Case cases[];
+} Zone;
+
+// Case d'une table de hachage associant un compte à une chaîne
+typedef struct CompteChaine
+{
+    char *chaine;
+    int nb;
+} CompteChaine;
+
+// Table de hachage à adressage ouvert, sa capacité est une puissance de 2
+typedef struct TableChaines
+{
+    CompteChaine *cases;
+    int capacite;
+    int nbChaines;
+} TableChaines;
+
+// Case d'une table de hachage associant un compte à une année
+typedef struct CompteAnnee
+{
+    int annee;
+    int nb;
+    bool estOccupee;
+} CompteAnnee;
+
+// Table de hachage à adressage ouvert, sa capacité est une puissance de 2
+typedef struct TableAnnees
+{
+    CompteAnnee *cases;
+    int capacite;
+    int nbAnnees;
+} TableAnnees;
+
+// Agrégats sur les voitures d'une chaîne
+typedef struct Statistiques
+{
+    int nbVoitures;
+    int anneeMin;
+    int anneeMax;
+    long long sommeAnnees;
+    long long kilometrageTotal;
+    // nombre de voitures par année, creux : sa taille ne dépend pas de l'écart entre les années
+    TableAnnees annees;
+    // nombre de voitures par marque
+    TableChaines marques;
+} Statistiques;
+
+// Chaîne d'éléments partagée entre une collection et ses copies.
+// Elle n'est dupliquée qu'au moment où l'une des collections la modifie.
+typedef struct Chaine
+{
+    int nbReferences;
+    Statistiques stats;
+    // zones contenant des éléments de la chaîne, triées par adresse
+    Zone **zones;
+    int nbZones;
+    int capaciteZones;
+} Chaine;
+
 struct CollectionP
 {
     Element *premier;
     Element *dernier;
     int nombreVoitures;
     bool estTrie;
+    // longueur du début de liste dont on sait qu'il est trié,
+    // estTrie équivaut à tailleTriee == nombreVoitures
+    int tailleTriee;
+    Chaine *chaine;
 };
 
 /*----------*
- * initialisation de la structure
+ * table de hachage de chaînes (marques, immatriculations)
  *----------*/
 
-// @brief Créer une collection initialisée en tant que collection vide
-Collection col_creer()
+static void table_initialiser(TableChaines *table)
 {
-    Collection result = malloc(sizeof(struct CollectionP));
-    // Dans le cas ou la mémoire n'est pas allouée correctement, le programme échoue
-    if (result == NULL)
+    table->cases = NULL;
+    table->capacite = 0;
+    table->nbChaines = 0;
+}
+
+static void table_detruire(TableChaines *table)
+{
+    for (int i = 0; i < table->capacite; i++)
     {
-        fprintf(stderr, "Error:Collection - col_creer - mem alloc failed");
-        exit(EXIT_FAILURE);
+        free(table->cases[i].chaine);
     }
-    result->premier = NULL;
-    result->dernier = NULL;
-    result->nombreVoitures = 0;
-    result->estTrie = true;
-    return result;
+    free(table->cases);
 }
 
-// @brief Créer une collection a partir d'une autre collection (clone)
-Collection col_creerCopie(const_Collection source)
+static unsigned int chaine_hacher(const char *chaine)
 {
-    myassert(source != NULL, "col_creerCopie - Source is null");
+    unsigned int hache = 2166136261u;
+    while (*chaine != '\0')
+    {
+        hache = (hache ^ (unsigned char)*chaine) * 16777619u;
+        chaine++;
+    }
+    return hache;
+}
 
-    Collection result = malloc(sizeof(struct CollectionP));
-    // Dans le cas ou la mémoire n'est pas allouée correctement, le programme échoue
-    if (result == NULL)
+// @brief Retourne la case de la chaîne dans la table, vide si elle est absente
+//        note : la table ne doit pas être vide
+static CompteChaine *table_trouver(const TableChaines *table, const char *chaine)
+{
+    unsigned int i = chaine_hacher(chaine) & (table->capacite - 1);
+    while (table->cases[i].chaine != NULL && strcmp(table->cases[i].chaine, chaine) != 0)
     {
-        fprintf(stderr, "Error:Collection - col_creer - mem alloc failed");
-        exit(EXIT_FAILURE);
+        i = (i + 1) & (table->capacite - 1);
     }
+    return &(table->cases[i]);
+}
 
-    result->nombreVoitures = source->nombreVoitures;
-    result->estTrie = source->estTrie;
+// @brief Retourne le compte associé à la chaîne, 0 si elle est absente
+static int table_getNb(const TableChaines *table, const char *chaine)
+{
+    if (table->capacite == 0)
+        return 0;
+    return table_trouver(table, chaine)->nb;
+}
 
-    // Si le premier est NULL, alors la liste est vide.
-    if (source->premier == NULL)
+// @brief Ajoute delta au compte de la chaîne
+static void table_compter(TableChaines *table, const char *chaine, int delta)
+{
+    // La table reste au plus à moitié pleine
+    if (2 * (table->nbChaines + 1) > table->capacite)
     {
-        result->premier = NULL;
-        result->dernier = NULL;
+        CompteChaine *anciennes = table->cases;
+        int ancienneCapacite = table->capacite;
+        table->capacite = ancienneCapacite == 0 ? 16 : 2 * ancienneCapacite;
+        table->cases = calloc(table->capacite, sizeof(CompteChaine));
+        if (table->cases == NULL)
+        {
+            fprintf(stderr, "Error:Collection - table_compter - mem alloc failed");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < ancienneCapacite; i++)
+        {
+            if (anciennes[i].chaine != NULL)
+                *table_trouver(table, anciennes[i].chaine) = anciennes[i];
+        }
+        free(anciennes);
     }
-    else
-    {
-        Element *elementActuel = source->premier;
-        Element *elementPrecedent = NULL;
 
-        // On passe par tous les éléments du la source
-        for (int i = 0; i < result->nombreVoitures; i++)
+    CompteChaine *compte = table_trouver(table, chaine);
+    if (compte->chaine == NULL)
+    {
+        // Les chaînes dont le compte retombe à 0 restent dans la table
+        compte->chaine = malloc(strlen(chaine) + 1);
+        if (compte->chaine == NULL)
         {
-            Element *element = malloc(sizeof(Element));
-            // Dans le cas ou la mémoire n'est pas allouée correctement, le programme échoue
-            if (element == NULL)
-            {
-                fprintf(stderr, "Error:Collection - col_creer - mem alloc failed");
-                exit(EXIT_FAILURE);
-            }
+            fprintf(stderr, "Error:Collection - table_compter - mem alloc failed");
+            exit(EXIT_FAILURE);
+        }
+        strcpy(compte->chaine, chaine);
+        compte->nb = 0;
+        table->nbChaines++;
+    }
+    compte->nb += delta;
+}
 
-            element->voiture = voi_creerCopie(elementActuel->voiture);
+/*----------*
+ * table de hachage des années
+ *----------*/
 
-            element->precedent = elementPrecedent;
-            if (elementPrecedent == NULL)
-            {
-                result->premier = element;
-            }
-            else
-            {
-                elementPrecedent->suivant = element;
-            }
+static void tableAnnees_initialiser(TableAnnees *table)
+{
+    table->cases = NULL;
+    table->capacite = 0;
+    table->nbAnnees = 0;
+}
 
-            // Gestion de la fin de la liste
-            if (source->dernier == elementActuel)
-            {
-                result->dernier = element;
-                element->suivant = NULL;
-            }
+static void tableAnnees_detruire(TableAnnees *table)
+{
+    free(table->cases);
+}
 
-            elementPrecedent = element;
-            elementActuel = elementActuel->suivant;
-        }
+// @brief Retourne la case de l'année dans la table, vide si elle est absente
+//        note : la table ne doit pas être vide
+static CompteAnnee *tableAnnees_trouver(const TableAnnees *table, int annee)
+{
+    unsigned int i = ((unsigned int)annee * 2654435761u) & (table->capacite - 1);
+    while (table->cases[i].estOccupee && table->cases[i].annee != annee)
+    {
+        i = (i + 1) & (table->capacite - 1);
     }
-    return result;
+    return &(table->cases[i]);
 }
 
-// @brief Détruit la collection
-void col_detruire(Collection *pself)
+// @brief Retourne le compte associé à l'année, 0 si elle est absente
+static int tableAnnees_getNb(const TableAnnees *table, int annee)
+{
+    if (table->capacite == 0)
+        return 0;
+    return tableAnnees_trouver(table, annee)->nb;
+}
+
+// @brief Ajoute delta au compte de l'année
+static void tableAnnees_compter(TableAnnees *table, int annee, int delta)
 {
-    Element *element = (*pself)->premier;
-    Element *elementSuivant = NULL;
-    if (element != NULL && element->suivant != NULL)
+    // La table reste au plus à moitié pleine
+    if (2 * (table->nbAnnees + 1) > table->capacite)
+    {
+        CompteAnnee *anciennes = table->cases;
+        int ancienneCapacite = table->capacite;
+        table->capacite = ancienneCapacite == 0 ? 16 : 2 * ancienneCapacite;
+        table->cases = calloc(table->capacite, sizeof(CompteAnnee));
+        if (table->cases == NULL)
+        {
+            fprintf(stderr, "Error:Collection - tableAnnees_compter - mem alloc failed");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < ancienneCapacite; i++)
+        {
+            if (anciennes[i].estOccupee)
+                *tableAnnees_trouver(table, anciennes[i].annee) = anciennes[i];
+        }
+        free(anciennes);
+    }
+
+    CompteAnnee *compte = tableAnnees_trouver(table, annee);
+    if (!compte->estOccupee)
     {
-        elementSuivant = element->suivant;
+        // Les années dont le compte retombe à 0 restent dans la table
+        compte->annee = annee;
+        compte->nb = 0;
+        compte->estOccupee = true;
+        table->nbAnnees++;
     }
-    for (int i = 0; i < (*pself)->nombreVoitures; i++)
+    compte->nb += delta;
+}
+
+/*----------*
+ * statistiques
+ * maintenues à chaque ajout ou suppression, sans parcours de la liste
+ *----------*/
+
+// @brief Créer des statistiques vides
+static void stats_initialiser(Statistiques *stats)
+{
+    stats->nbVoitures = 0;
+    stats->anneeMin = 0;
+    stats->anneeMax = 0;
+    stats->sommeAnnees = 0;
+    stats->kilometrageTotal = 0;
+    tableAnnees_initialiser(&(stats->annees));
+    table_initialiser(&(stats->marques));
+}
+
+static void stats_detruire(Statistiques *stats)
+{
+    table_detruire(&(stats->marques));
+    tableAnnees_detruire(&(stats->annees));
+}
+
+// @brief Ajoute nb voitures de l'année et met à jour les bornes
+static void stats_compterAnnee(Statistiques *stats, int annee, int nb)
+{
+    tableAnnees_compter(&(stats->annees), annee, nb);
+    if (stats->nbVoitures == 0 || annee < stats->anneeMin)
+        stats->anneeMin = annee;
+    if (stats->nbVoitures == 0 || annee > stats->anneeMax)
+        stats->anneeMax = annee;
+    stats->nbVoitures += nb;
+    stats->sommeAnnees += (long long)annee * nb;
+}
+
+// @brief Compte la voiture dans les statistiques
+//        note : sa marque est copiée dans un tableau de COL_MAX_LEN + 1 caractères
+static void stats_ajouter(Statistiques *stats, const_Voiture voiture)
+{
+    char marque[COL_MAX_LEN + 1];
+    voi_getMarque(voiture, marque);
+    table_compter(&(stats->marques), marque, 1);
+    stats_compterAnnee(stats, voi_getAnnee(voiture), 1);
+    stats->kilometrageTotal += voi_getKilometrage(voiture);
+}
+
+static void stats_retirer(Statistiques *stats, const_Voiture voiture)
+{
+    char marque[COL_MAX_LEN + 1];
+    voi_getMarque(voiture, marque);
+    table_compter(&(stats->marques), marque, -1);
+
+    int annee = voi_getAnnee(voiture);
+    tableAnnees_compter(&(stats->annees), annee, -1);
+    stats->nbVoitures--;
+    stats->sommeAnnees -= annee;
+    stats->kilometrageTotal -= voi_getKilometrage(voiture);
+
+    // Les bornes ne bougent que si leur année se vide, elles sont alors recalculées
+    // en un parcours de la table (au plus deux fois le nombre d'années différentes)
+    if (stats->nbVoitures > 0 && tableAnnees_getNb(&(stats->annees), annee) == 0
+        && (annee == stats->anneeMin || annee == stats->anneeMax))
     {
-        voi_detruire(&(element->voiture));
-        free(element);
-        element = elementSuivant;
-        if (elementSuivant != NULL)
+        bool estPremiere = true;
+        for (int i = 0; i < stats->annees.capacite; i++)
         {
-            elementSuivant = elementSuivant->suivant;
+            const CompteAnnee *compte = &(stats->annees.cases[i]);
+            if (!compte->estOccupee || compte->nb == 0)
+                continue;
+            if (estPremiere || compte->annee < stats->anneeMin)
+                stats->anneeMin = compte->annee;
+            if (estPremiere || compte->annee > stats->anneeMax)
+                stats->anneeMax = compte->annee;
+            estPremiere = false;
         }
     }
-    free(*pself);
-    *pself = NULL;
 }
 
-// @brief Vide la collection
-void col_vider(Collection self)
+// @brief Ajoute les statistiques de source à celles de dest
+static void stats_fusionner(Statistiques *dest, const Statistiques *source)
 {
-    Element *element = self->premier;
-    Element *elementSuivant;
-    if (element != NULL && element->suivant != NULL)
+    for (int i = 0; i < source->annees.capacite; i++)
     {
-        elementSuivant = element->suivant;
+        const CompteAnnee *compte = &(source->annees.cases[i]);
+        if (compte->estOccupee && compte->nb != 0)
+            stats_compterAnnee(dest, compte->annee, compte->nb);
     }
-    for (int i = 0; i < self->nombreVoitures; i++)
+    for (int i = 0; i < source->marques.capacite; i++)
     {
-        voi_detruire(&(element->voiture));
-        free(element);
-        element = elementSuivant;
-        if (elementSuivant != NULL)
-        {
-            elementSuivant = elementSuivant->suivant;
-        }
+        const CompteChaine *compte = &(source->marques.cases[i]);
+        if (compte->chaine != NULL && compte->nb != 0)
+            table_compter(&(dest->marques), compte->chaine, compte->nb);
     }
-    self->premier = NULL;
-    self->dernier = NULL;
-    self->nombreVoitures = 0;
-    self->estTrie = true;
+    dest->kilometrageTotal += source->kilometrageTotal;
 }
 
 /*----------*
- * accesseurs
+ * gestion du partage (copy-on-write)
  *----------*/
-// @brief Retourne le nombre de voitures contenues dans la collection
-int col_getNbVoitures(const_Collection self)
+
+// @brief Encapsule une voiture (dont on prend possession) dans un bloc partagé
+static VoiturePartagee *partage_creer(Voiture voiture)
 {
-    myassert(self != NULL, "col_getNbVoitures - input invalid");
-    return self->nombreVoitures;
+    VoiturePartagee *result = malloc(sizeof(VoiturePartagee));
+    // Dans le cas ou la mémoire n'est pas allouée correctement, le programme échoue
+    if (result == NULL)
+    {
+        fprintf(stderr, "Error:Collection - partage_creer - mem alloc failed");
+        exit(EXIT_FAILURE);
+    }
+    result->voiture = voiture;
+    result->nbReferences = 1;
+    result->zone = NULL;
+    return result;
 }
 
-// @brief Retourne une copie de la voiture contenue en [pos]
-Voiture col_getVoiture(const_Collection self, int pos)
+// @brief Ajoute une référence sur une voiture partagée
+static VoiturePartagee *partage_retenir(VoiturePartagee *partage)
 {
-    myassert(self != NULL, "col_getVoiture - Collection is null");
-    myassert((pos >= 0) && (pos < self->nombreVoitures), "col_getVoiture - Position not valid");
+    partage->nbReferences++;
+    return partage;
+}
 
-    // On regarde si la position est dans la première ou deuxième moitié de la liste afin d'effectuer le minimum d'opérations
-    if (pos < (self->nombreVoitures / 2))
+// @brief Libère la zone quand plus rien ne l'utilise
+static void zone_relacher(Zone *zone)
+{
+    if (zone->nbElements == 0 && zone->nbPartages == 0)
+        free(zone);
+}
+
+// @brief Retire une référence, la voiture est détruite à la dernière
+static void partage_liberer(VoiturePartagee *partage)
+{
+    partage->nbReferences--;
+    if (partage->nbReferences == 0)
     {
-        Element *element = self->premier;
-        for (int i = 0; i < pos; i++)
+        voi_detruire(&(partage->voiture));
+        if (partage->zone == NULL)
         {
-            element = element->suivant;
+            free(partage);
         }
-        return voi_creerCopie(element->voiture);
-    }
-    else
-    {
-        Element *element = self->dernier;
-        // On parcours la liste en partant de la fin
-        for (int i = self->nombreVoitures - 1; i > pos; i--)
+        else
         {
-            element = element->precedent;
+            partage->zone->nbPartages--;
+            zone_relacher(partage->zone);
         }
-        return voi_creerCopie(element->voiture);
     }
 }
 
-// @brief Ajoute la voiture à la fin de la chaine
-void col_addVoitureSansTri(Collection self, const_Voiture voiture)
+// @brief Créer un élément non chaîné contenant la voiture partagée
+static Element *element_creer(VoiturePartagee *partage)
 {
-    myassert(self != NULL, "col_addVoitureSansTri - Collection is null");
-    myassert(voiture != NULL, "col_addVoitureSansTri - Car is null");
-
     Element *element = malloc(sizeof(Element));
-
     // Dans le cas ou la mémoire n'est pas allouée correctement, le programme échoue
     if (element == NULL)
     {
-        fprintf(stderr, "Error:Collection - addVoitureSansTri - mem alloc failed");
+        fprintf(stderr, "Error:Collection - element_creer - mem alloc failed");
         exit(EXIT_FAILURE);
     }
+    element->partage = partage;
+    element->precedent = NULL;
+    element->suivant = NULL;
+    return element;
+}
 
-    element->voiture = voi_creerCopie(voiture);
-
-    // Dans le cas ou la liste est vide
-    if (self->nombreVoitures == 0)
+// @brief Retourne l'indice de la première zone de la chaîne située après adresse
+static int chaine_chercherZone(const Chaine *chaine, uintptr_t adresse)
+{
+    int debut = 0;
+    int fin = chaine->nbZones;
+    while (debut < fin)
     {
-        element->suivant = NULL;
-        element->precedent = NULL;
-        self->premier = element;
-        self->dernier = element;
+        int milieu = debut + (fin - debut) / 2;
+        if ((uintptr_t)chaine->zones[milieu] <= adresse)
+            debut = milieu + 1;
+        else
+            fin = milieu;
     }
-    else
+    return debut;
+}
+
+// @brief Retourne la zone de la chaîne qui contient l'élément, NULL s'il est alloué seul
+static Zone *chaine_trouverZone(const Chaine *chaine, const Element *element)
+{
+    int i = chaine_chercherZone(chaine, (uintptr_t)element);
+    if (i == 0)
+        return NULL;
+    Zone *zone = chaine->zones[i - 1];
+    if ((uintptr_t)element >= (uintptr_t)(zone->cases + zone->nbCases))
+        return NULL;
+    return zone;
+}
+
+// @brief Ajoute la zone au tableau trié de la chaîne
+static void chaine_ajouterZone(Chaine *chaine, Zone *zone)
+{
+    if (chaine->nbZones == chaine->capaciteZones)
     {
-        self->dernier->suivant = element;
-        element->suivant = NULL;
-        element->precedent = self->dernier;
-        self->dernier = element;
+        chaine->capaciteZones = chaine->capaciteZones == 0 ? 4 : 2 * chaine->capaciteZones;
+        chaine->zones = realloc(chaine->zones, sizeof(Zone *) * chaine->capaciteZones);
+        if (chaine->zones == NULL)
+        {
+            fprintf(stderr, "Error:Collection - chaine_ajouterZone - mem alloc failed");
+            exit(EXIT_FAILURE);
+        }
     }
+    int i = chaine_chercherZone(chaine, (uintptr_t)zone);
+    memmove(chaine->zones + i + 1, chaine->zones + i, sizeof(Zone *) * (chaine->nbZones - i));
+    chaine->zones[i] = zone;
+    chaine->nbZones++;
+}
 
-    self->nombreVoitures++;
+// @brief Détruit un élément de la chaîne et libère sa voiture
+static void element_detruire(Chaine *chaine, Element *element)
+{
+    partage_liberer(element->partage);
 
-    if (self->nombreVoitures > 1)
+    Zone *zone = chaine_trouverZone(chaine, element);
+    if (zone == NULL)
     {
-        self->estTrie = false;
+        free(element);
+        return;
     }
-    else
+    zone->nbElements--;
+    if (zone->nbElements == 0)
     {
-        self->estTrie = true;
+        // La zone ne contient plus d'élément de la chaîne
+        int i = chaine_chercherZone(chaine, (uintptr_t)zone) - 1;
+        memmove(chaine->zones + i, chaine->zones + i + 1, sizeof(Zone *) * (chaine->nbZones - i - 1));
+        chaine->nbZones--;
+        zone_relacher(zone);
     }
 }
 
-// @brief Ajoute un voiture à sa position triée
-void col_addVoitureAvecTri(Collection self, const_Voiture voiture)
+// @brief Détruit un élément déjà retiré de la liste de self, en mettant à jour les statistiques
+static void col_detruireElement(Collection self, Element *element)
 {
-    myassert(self != NULL, "col_addVoitureAvecTri - Collection is null");
-    myassert(self->estTrie, "col_addVoitureSansTri - Collection not sorted");
-    myassert(voiture != NULL, "col_addVoitureSansTri - Car is null");
+    stats_retirer(&(self->chaine->stats), element->partage->voiture);
+    element_detruire(self->chaine, element);
+}
 
-    Element *element = malloc(sizeof(Element));
+// @brief Créer une chaîne possédée par une seule collection
+static Chaine *chaine_creer()
+{
+    Chaine *result = malloc(sizeof(Chaine));
     // Dans le cas ou la mémoire n'est pas allouée correctement, le programme échoue
-    if (element == NULL)
+    if (result == NULL)
     {
-        fprintf(stderr, "Error:Collection - addVoitureSansTri - mem alloc failed");
+        fprintf(stderr, "Error:Collection - chaine_creer - mem alloc failed");
         exit(EXIT_FAILURE);
     }
+    result->nbReferences = 1;
+    stats_initialiser(&(result->stats));
+    result->zones = NULL;
+    result->nbZones = 0;
+    result->capaciteZones = 0;
+    return result;
+}
 
-    element->voiture = voi_creerCopie(voiture);
-
-    if (voi_getAnnee(self->premier->voiture) > voi_getAnnee(voiture))
-    {
-        // On ajoute la voiture au début de la liste chaînée
-        self->premier->precedent = element;
-        element->precedent = NULL;
-        element->suivant = self->premier;
-        self->premier = element;
-    }
-    else if (voi_getAnnee(self->dernier->voiture) < voi_getAnnee(voiture))
-    {
-        // On ajoute la voiture à la fin de la liste chaînée
-        self->dernier->suivant = element;
-        element->suivant = NULL;
-        element->precedent = self->dernier;
-        self->dernier = element;
-    }
-    else
+// @brief Abandonne la chaîne de self : les éléments ne sont détruits que si
+//        aucune autre collection ne la partage
+static void col_libererChaine(Collection self)
+{
+    self->chaine->nbReferences--;
+    if (self->chaine->nbReferences == 0)
     {
-        // On ajoute la voiture entre 2 autres voitures de la liste chaînée
-        Element *temp = self->premier;
-        while (temp != NULL && (voi_getAnnee(element->voiture) > voi_getAnnee(temp->voiture)))
+        Element *element = self->premier;
+        while (element != NULL)
         {
-            // On arrete la boucle quand on trouve un élément qui est plus grand que l'élément qu'on veut placer
-            // L'élément temp est donc l'élément qui suit l'élément qu'on veut placer dans un ordre trié
-            temp = temp->suivant;
+            Element *elementSuivant = element->suivant;
+            element_detruire(self->chaine, element);
+            element = elementSuivant;
         }
-        // On créé alors tous les liens entre les différents éléments de la liste chaînée
-        temp->precedent->suivant = element;
-        element->precedent = temp->precedent;
-        temp->precedent = element;
-        element->suivant = temp;
+        stats_detruire(&(self->chaine->stats));
+        free(self->chaine->zones);
+        free(self->chaine);
     }
-    self->nombreVoitures++;
+    self->chaine = NULL;
 }
 
-// @brief Supprime la voiture en [pos]
-void col_supprVoitureSansTri(Collection self, int pos)
+// @brief A appeler avant toute modification de self : si la chaîne est partagée,
+//        self en prend une copie privée. Seuls les éléments sont dupliqués,
+//        les voitures restent partagées.
+static void col_detacher(Collection self)
 {
-    myassert(self != NULL, "col_supprVoitureSansTri - Collection is null");
-    myassert((pos >= 0) && (pos < self->nombreVoitures), "col_supprVoitureSansTri - Position not valid");
+    if (self->chaine->nbReferences == 1)
+        return;
 
-    Element *aSupprimer;
-    if (pos == 0)
-    {
-        aSupprimer = self->premier;
-        aSupprimer->suivant->precedent = NULL;
-        self->premier = aSupprimer->suivant;
-        voi_detruire(&(aSupprimer->voiture));
-        free(aSupprimer);
-    }
-    else if (pos == self->nombreVoitures - 1)
+    Chaine *ancienne = self->chaine;
+    ancienne->nbReferences--;
+    self->chaine = chaine_creer();
+    stats_fusionner(&(self->chaine->stats), &(ancienne->stats));
+
+    Element *elementActuel = self->premier;
+    Element *elementPrecedent = NULL;
+    self->premier = NULL;
+    while (elementActuel != NULL)
     {
-        aSupprimer = self->dernier;
-        aSupprimer->precedent->suivant = NULL;
-        self->dernier = aSupprimer->precedent;
-        voi_detruire(&(aSupprimer->voiture));
-        free(aSupprimer);
+        Element *element = element_creer(partage_retenir(elementActuel->partage));
+        element->precedent = elementPrecedent;
+        if (elementPrecedent == NULL)
+            self->premier = element;
+        else
+            elementPrecedent->suivant = element;
+
+        elementPrecedent = element;
+        elementActuel = elementActuel->suivant;
+    }
+    self->dernier = elementPrecedent;
+}
+
+/*----------*
+ * initialisation de la structure
+ *----------*/
+
+// @brief Créer une collection initialisée en tant que collection vide
+Collection col_creer()
+{
+    Collection result = malloc(sizeof(struct CollectionP));
+    // Dans le cas ou la mémoire n'est pas allouée correctement, le programme échoue
+    if (result == NULL)
+    {
+        fprintf(stderr, "Error:Collection - col_creer - mem alloc failed");
+        exit(EXIT_FAILURE);
+    }
+    result->premier = NULL;
+    result->dernier = NULL;
+    result->nombreVoitures = 0;
+    result->estTrie = true;
+    result->tailleTriee = 0;
+    result->chaine = chaine_creer();
+    return result;
+}
+
+// @brief Créer une collection a partir d'une autre collection (clone)
+//        La copie est en O(1) : les éléments et les voitures sont partagés avec
+//        la source et ne sont dupliqués qu'à la première modification (copy-on-write)
+Collection col_creerCopie(const_Collection source)
+{
+    myassert(source != NULL, "col_creerCopie - Source is null");
+
+    Collection result = malloc(sizeof(struct CollectionP));
+    // Dans le cas ou la mémoire n'est pas allouée correctement, le programme échoue
+    if (result == NULL)
+    {
+        fprintf(stderr, "Error:Collection - col_creerCopie - mem alloc failed");
+        exit(EXIT_FAILURE);
+    }
+
+    *result = *source;
+    result->chaine->nbReferences++;
+    return result;
+}
+
+// @brief Détruit la collection
+void col_detruire(Collection *pself)
+{
+    col_libererChaine(*pself);
+    free(*pself);
+    *pself = NULL;
+}
+
+// @brief Vide la collection
+void col_vider(Collection self)
+{
+    col_libererChaine(self);
+    self->chaine = chaine_creer();
+    self->premier = NULL;
+    self->dernier = NULL;
+    self->nombreVoitures = 0;
+    self->estTrie = true;
+    self->tailleTriee = 0;
+}
+
+/*----------*
+ * accesseurs
+ *----------*/
+// @brief Retourne le nombre de voitures contenues dans la collection
+int col_getNbVoitures(const_Collection self)
+{
+    myassert(self != NULL, "col_getNbVoitures - input invalid");
+    return self->nombreVoitures;
+}
+
+// @brief Retourne une copie de la voiture contenue en [pos]
+Voiture col_getVoiture(const_Collection self, int pos)
+{
+    myassert(self != NULL, "col_getVoiture - Collection is null");
+    myassert((pos >= 0) && (pos < self->nombreVoitures), "col_getVoiture - Position not valid");
+
+    // On regarde si la position est dans la première ou deuxième moitié de la liste afin d'effectuer le minimum d'opérations
+    if (pos < (self->nombreVoitures / 2))
+    {
+        Element *element = self->premier;
+        for (int i = 0; i < pos; i++)
+        {
+            element = element->suivant;
+        }
+        return voi_creerCopie(element->partage->voiture);
+    }
+    else
+    {
+        Element *element = self->dernier;
+        // On parcours la liste en partant de la fin
+        for (int i = self->nombreVoitures - 1; i > pos; i--)
+        {
+            element = element->precedent;
+        }
+        return voi_creerCopie(element->partage->voiture);
+    }
+}
+
+// @brief Modifie le kilométrage de la voiture en [pos]
+//        Une voiture partagée avec une autre collection est d'abord copiée
+void col_setKilometrage(Collection self, int pos, int kilometrage)
+{
+    myassert(self != NULL, "col_setKilometrage - Collection is null");
+    myassert((pos >= 0) && (pos < self->nombreVoitures), "col_setKilometrage - Position not valid");
+
+    col_detacher(self);
+
+    // On part de l'extrémité la plus proche de pos, comme col_getVoiture
+    Element *element;
+    if (pos < (self->nombreVoitures / 2))
+    {
+        element = self->premier;
+        for (int i = 0; i < pos; i++)
+        {
+            element = element->suivant;
+        }
+    }
+    else
+    {
+        element = self->dernier;
+        for (int i = self->nombreVoitures - 1; i > pos; i--)
+        {
+            element = element->precedent;
+        }
+    }
+    if (element->partage->nbReferences > 1)
+    {
+        VoiturePartagee *copie = partage_creer(voi_creerCopie(element->partage->voiture));
+        partage_liberer(element->partage);
+        element->partage = copie;
+    }
+
+    self->chaine->stats.kilometrageTotal -= voi_getKilometrage(element->partage->voiture);
+    voi_setKilometrage(element->partage->voiture, kilometrage);
+    self->chaine->stats.kilometrageTotal += voi_getKilometrage(element->partage->voiture);
+}
+
+// @brief Ajoute un élément (non chaîné) à la fin de self
+static void col_ajouterElementFin(Collection self, Element *element)
+{
+    stats_ajouter(&(self->chaine->stats), element->partage->voiture);
+    if (self->tailleTriee == self->nombreVoitures
+        && (self->nombreVoitures == 0
+            || voi_getAnnee(self->dernier->partage->voiture) <= voi_getAnnee(element->partage->voiture)))
+    {
+        self->tailleTriee++;
+    }
+
+    element->precedent = self->dernier;
+    element->suivant = NULL;
+    if (self->dernier == NULL)
+        self->premier = element;
+    else
+        self->dernier->suivant = element;
+    self->dernier = element;
+    self->nombreVoitures++;
+    self->estTrie = (self->tailleTriee == self->nombreVoitures);
+}
+
+// @brief Ajoute la voiture à la fin de la chaine
+void col_addVoitureSansTri(Collection self, const_Voiture voiture)
+{
+    myassert(self != NULL, "col_addVoitureSansTri - Collection is null");
+    myassert(voiture != NULL, "col_addVoitureSansTri - Car is null");
+
+    col_detacher(self);
+
+    Element *element = element_creer(partage_creer(voi_creerCopie(voiture)));
+    stats_ajouter(&(self->chaine->stats), voiture);
+
+    // Le début trié s'allonge tant que les voitures arrivent dans l'ordre
+    if (self->tailleTriee == self->nombreVoitures
+        && (self->nombreVoitures == 0 || voi_getAnnee(self->dernier->partage->voiture) <= voi_getAnnee(voiture)))
+    {
+        self->tailleTriee++;
+    }
+
+    // Dans le cas ou la liste est vide
+    if (self->nombreVoitures == 0)
+    {
+        element->suivant = NULL;
+        element->precedent = NULL;
+        self->premier = element;
+        self->dernier = element;
+    }
+    else
+    {
+        self->dernier->suivant = element;
+        element->suivant = NULL;
+        element->precedent = self->dernier;
+        self->dernier = element;
+    }
+
+    self->nombreVoitures++;
+    self->estTrie = (self->tailleTriee == self->nombreVoitures);
+}
+
+// @brief Ajoute un voiture à sa position triée
+//        La collection est triée au préalable si besoin
+void col_addVoitureAvecTri(Collection self, const_Voiture voiture)
+{
+    myassert(self != NULL, "col_addVoitureAvecTri - Collection is null");
+    myassert(voiture != NULL, "col_addVoitureSansTri - Car is null");
+
+    col_trier(self);
+    col_detacher(self);
+
+    Element *element = element_creer(partage_creer(voi_creerCopie(voiture)));
+
+    // A année égale, la voiture est placée après celles déjà présentes
+    if (self->nombreVoitures == 0 || voi_getAnnee(self->dernier->partage->voiture) <= voi_getAnnee(voiture))
+    {
+        // On ajoute la voiture à la fin de la liste chaînée (ou dans la liste vide)
+        col_ajouterElementFin(self, element);
+        return;
+    }
+
+    stats_ajouter(&(self->chaine->stats), voiture);
+    if (voi_getAnnee(self->premier->partage->voiture) > voi_getAnnee(voiture))
+    {
+        // On ajoute la voiture au début de la liste chaînée
+        self->premier->precedent = element;
+        element->precedent = NULL;
+        element->suivant = self->premier;
+        self->premier = element;
+    }
+    else
+    {
+        // On ajoute la voiture entre 2 autres voitures de la liste chaînée
+        // temp existe et n'est pas le premier : la voiture n'est placée ni au début ni à la fin
+        Element *temp = self->premier;
+        while (voi_getAnnee(temp->partage->voiture) <= voi_getAnnee(element->partage->voiture))
+        {
+            // On arrete la boucle quand on trouve un élément qui est plus grand que l'élément qu'on veut placer
+            // L'élément temp est donc l'élément qui suit l'élément qu'on veut placer dans un ordre trié
+            temp = temp->suivant;
+        }
+        // On créé alors tous les liens entre les différents éléments de la liste chaînée
+        temp->precedent->suivant = element;
+        element->precedent = temp->precedent;
+        temp->precedent = element;
+        element->suivant = temp;
+    }
+    self->nombreVoitures++;
+    self->tailleTriee++;
+}
+
+// @brief Retire l'élément de la liste de self (sans le détruire)
+static void col_delier(Collection self, Element *element)
+{
+    if (element->precedent == NULL)
+        self->premier = element->suivant;
+    else
+        element->precedent->suivant = element->suivant;
+
+    if (element->suivant == NULL)
+        self->dernier = element->precedent;
+    else
+        element->suivant->precedent = element->precedent;
+
+    self->nombreVoitures--;
+}
+
+// @brief Supprime la voiture en [pos]
+void col_supprVoitureSansTri(Collection self, int pos)
+{
+    myassert(self != NULL, "col_supprVoitureSansTri - Collection is null");
+    myassert((pos >= 0) && (pos < self->nombreVoitures), "col_supprVoitureSansTri - Position not valid");
+
+    col_detacher(self);
+
+    // On part de l'extrémité la plus proche de pos
+    Element *aSupprimer;
+    if (pos < (self->nombreVoitures / 2))
+    {
+        aSupprimer = self->premier;
+        for (int i = 0; i < pos; i++)
+        {
+            aSupprimer = aSupprimer->suivant;
+        }
+    }
+    else
+    {
+        aSupprimer = self->dernier;
+        for (int i = self->nombreVoitures - 1; i > pos; i--)
+        {
+            aSupprimer = aSupprimer->precedent;
+        }
+    }
+    col_delier(self, aSupprimer);
+    col_detruireElement(self, aSupprimer);
+
+    // Retirer une voiture du début trié le laisse trié
+    if (pos < self->tailleTriee)
+        self->tailleTriee--;
+    self->estTrie = (self->tailleTriee == self->nombreVoitures);
+}
+
+// @brief Supprime la voiture en [pos]
+void col_supprVoitureAvecTri(Collection self, int pos)
+{
+    // On remarque que l'on utilise le même algorithme pour supprimer une voiture avec ou sans tri,
+    // On utilise donc la même fonction
+    col_supprVoitureSansTri(self, pos);
+}
+
+// @brief Supprime en un seul parcours toutes les voitures pour lesquelles predicat est vrai
+//        ctx est transmis tel quel au prédicat. Retourne le nombre de voitures supprimées.
+int col_supprimerSi(Collection self, ColPredicat predicat, void *ctx)
+{
+    myassert(self != NULL, "col_supprimerSi - Collection is null");
+    myassert(predicat != NULL, "col_supprimerSi - Predicate is null");
+
+    col_detacher(self);
+
+    int nbSupprimees = 0;
+    int nbSupprimeesTriees = 0;
+    int pos = 0;
+    Element *element = self->premier;
+    while (element != NULL)
+    {
+        Element *elementSuivant = element->suivant;
+        if (predicat(element->partage->voiture, ctx))
+        {
+            col_delier(self, element);
+            col_detruireElement(self, element);
+            nbSupprimees++;
+            if (pos < self->tailleTriee)
+                nbSupprimeesTriees++;
+        }
+        element = elementSuivant;
+        pos++;
+    }
+
+    self->tailleTriee -= nbSupprimeesTriees;
+    self->estTrie = (self->tailleTriee == self->nombreVoitures);
+    return nbSupprimees;
+}
+
+static int comparerEntiers(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+// @brief Supprime en un seul parcours les voitures aux positions données (dans n'importe quel ordre,
+//        les doublons sont ignorés). Retourne le nombre de voitures supprimées.
+int col_supprimerPositions(Collection self, const int positions[], int n)
+{
+    myassert(self != NULL, "col_supprimerPositions - Collection is null");
+    myassert(n >= 0, "col_supprimerPositions - n must be positive");
+    myassert(n == 0 || positions != NULL, "col_supprimerPositions - positions is null");
+
+    if (n == 0)
+        return 0;
+
+    int *triees = malloc(sizeof(int) * n);
+    if (triees == NULL)
+    {
+        fprintf(stderr, "Error:Collection - col_supprimerPositions - mem alloc failed");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(triees, positions, sizeof(int) * n);
+    qsort(triees, n, sizeof(int), comparerEntiers);
+    myassert(triees[0] >= 0 && triees[n - 1] < self->nombreVoitures, "col_supprimerPositions - Position not valid");
+
+    col_detacher(self);
+
+    int nbSupprimees = 0;
+    int nbSupprimeesTriees = 0;
+    int pos = 0;
+    int i = 0;
+    Element *element = self->premier;
+    while (i < n)
+    {
+        Element *elementSuivant = element->suivant;
+        if (pos == triees[i])
+        {
+            col_delier(self, element);
+            col_detruireElement(self, element);
+            nbSupprimees++;
+            if (pos < self->tailleTriee)
+                nbSupprimeesTriees++;
+            // On saute les doublons
+            while (i < n && triees[i] == pos)
+            {
+                i++;
+            }
+        }
+        element = elementSuivant;
+        pos++;
+    }
+    free(triees);
+
+    self->tailleTriee -= nbSupprimeesTriees;
+    self->estTrie = (self->tailleTriee == self->nombreVoitures);
+    return nbSupprimees;
+}
+
+// @brief Fusionne deux listes triées chaînées par suivant (les liens precedent sont ignorés)
+//        A année égale, les éléments de a restent avant ceux de b
+static Element *liste_fusionner(Element *a, Element *b, Element **pdernier)
+{
+    Element tete;
+    Element *queue = &tete;
+    while (a != NULL && b != NULL)
+    {
+        if (voi_getAnnee(b->partage->voiture) < voi_getAnnee(a->partage->voiture))
+        {
+            queue->suivant = b;
+            b = b->suivant;
+        }
+        else
+        {
+            queue->suivant = a;
+            a = a->suivant;
+        }
+        queue = queue->suivant;
+    }
+    queue->suivant = (a != NULL) ? a : b;
+    while (queue->suivant != NULL)
+    {
+        queue = queue->suivant;
+    }
+    *pdernier = (queue == &tete) ? NULL : queue;
+    return tete.suivant;
+}
+
+// @brief Rétablit les liens vers les éléments précédents d'une liste chaînée par suivant
+static void liste_relierPrecedents(Element *premier)
+{
+    Element *precedent = NULL;
+    for (Element *element = premier; element != NULL; element = element->suivant)
+    {
+        element->precedent = precedent;
+        precedent = element;
+    }
+}
+
+// @brief Détache de la liste la suite croissante qui la commence, et retourne le reste
+static Element *liste_couperSuite(Element *liste)
+{
+    while (liste->suivant != NULL
+           && voi_getAnnee(liste->suivant->partage->voiture) >= voi_getAnnee(liste->partage->voiture))
+    {
+        liste = liste->suivant;
+    }
+    Element *reste = liste->suivant;
+    liste->suivant = NULL;
+    return reste;
+}
+
+// @brief Tri fusion naturel d'une liste chaînée par suivant : les suites déjà croissantes
+//        sont fusionnées deux à deux, une liste presque triée se trie donc en temps quasi linéaire
+static Element *liste_trier(Element *liste)
+{
+    bool estTriee = false;
+    while (!estTriee && liste != NULL)
+    {
+        Element tete;
+        Element *queue = &tete;
+        int nbFusions = 0;
+        while (liste != NULL)
+        {
+            Element *suite1 = liste;
+            Element *suite2 = liste_couperSuite(suite1);
+            liste = (suite2 != NULL) ? liste_couperSuite(suite2) : NULL;
+            Element *dernier;
+            queue->suivant = liste_fusionner(suite1, suite2, &dernier);
+            queue = dernier;
+            nbFusions++;
+        }
+        liste = tete.suivant;
+        estTriee = (nbFusions == 1);
+    }
+    return liste;
+}
+
+// @brief Tri la collection self, de manière stable
+//        Seule la fin non triée est triée (tri fusion naturel), puis fusionnée avec le début trié
+void col_trier(Collection self)
+{
+    myassert(self != NULL, "col_trier - Collection is null");
+
+    if (!(self->estTrie))
+    {
+        col_detacher(self);
+
+        // On sépare le début trié du reste de la liste
+        Element *debut = NULL;
+        Element *fin = self->premier;
+        if (self->tailleTriee > 0)
+        {
+            Element *finDebut = self->premier;
+            for (int i = 1; i < self->tailleTriee; i++)
+            {
+                finDebut = finDebut->suivant;
+            }
+            debut = self->premier;
+            fin = finDebut->suivant;
+            finDebut->suivant = NULL;
+        }
+
+        Element *dernier;
+        self->premier = liste_fusionner(debut, liste_trier(fin), &dernier);
+        self->dernier = dernier;
+        liste_relierPrecedents(self->premier);
+
+        self->tailleTriee = self->nombreVoitures;
+        self->estTrie = true;
+    }
+}
+
+/*----------*
+ * combinaison de collections
+ *----------*/
+
+// @brief Vide self sans détruire ses éléments, qui ont été déplacés dans destination
+//        Les zones qui les contiennent passent à la chaîne de destination
+//        note : les chaînes de self et de destination ne doivent pas être partagées
+static void col_abandonnerElements(Collection self, Collection destination)
+{
+    for (int i = 0; i < self->chaine->nbZones; i++)
+    {
+        chaine_ajouterZone(destination->chaine, self->chaine->zones[i]);
+    }
+    self->chaine->nbZones = 0;
+
+    stats_detruire(&(self->chaine->stats));
+    stats_initialiser(&(self->chaine->stats));
+    self->premier = NULL;
+    self->dernier = NULL;
+    self->nombreVoitures = 0;
+    self->estTrie = true;
+    self->tailleTriee = 0;
+}
+
+// @brief Fusionne source dans self en un seul parcours, les deux collections étant triées au préalable
+//        Si deplacer est vrai, les éléments de source sont déplacés dans self et source est vidée,
+//        sinon source est conservée et ses voitures sont partagées avec self (sans copie)
+void col_fusionner(Collection self, Collection source, bool deplacer)
+{
+    myassert(self != NULL && source != NULL, "col_fusionner - Collection is null");
+    myassert(self != source, "col_fusionner - Collections must be different");
+
+    col_trier(self);
+    col_trier(source);
+    col_detacher(self);
+
+    int nbVoitures = source->nombreVoitures;
+    stats_fusionner(&(self->chaine->stats), &(source->chaine->stats));
+
+    Element *aFusionner;
+    if (deplacer)
+    {
+        col_detacher(source);
+        aFusionner = source->premier;
+        col_abandonnerElements(source, self);
+    }
+    else
+    {
+        Element tete;
+        Element *queue = &tete;
+        for (Element *element = source->premier; element != NULL; element = element->suivant)
+        {
+            queue->suivant = element_creer(partage_retenir(element->partage));
+            queue = queue->suivant;
+        }
+        queue->suivant = NULL;
+        aFusionner = tete.suivant;
+    }
+
+    Element *dernier;
+    self->premier = liste_fusionner(self->premier, aFusionner, &dernier);
+    self->dernier = dernier;
+    liste_relierPrecedents(self->premier);
+
+    self->nombreVoitures += nbVoitures;
+    self->tailleTriee = self->nombreVoitures;
+    self->estTrie = true;
+}
+
+// @brief Déplace les éléments de source à la fin de self, source est vidée
+//        Les listes sont raccordées par leurs extrémités, sans parcours
+void col_concatener(Collection self, Collection source)
+{
+    myassert(self != NULL && source != NULL, "col_concatener - Collection is null");
+    myassert(self != source, "col_concatener - Collections must be different");
+
+    if (source->nombreVoitures == 0)
+        return;
+
+    col_detacher(self);
+    col_detacher(source);
+
+    // Le début trié se prolonge dans source si self est entièrement triée et que source la continue
+    if (self->estTrie
+        && (self->nombreVoitures == 0
+            || voi_getAnnee(self->dernier->partage->voiture) <= voi_getAnnee(source->premier->partage->voiture)))
+    {
+        self->tailleTriee = self->nombreVoitures + source->tailleTriee;
+    }
+
+    source->premier->precedent = self->dernier;
+    if (self->dernier == NULL)
+        self->premier = source->premier;
+    else
+        self->dernier->suivant = source->premier;
+    self->dernier = source->dernier;
+    self->nombreVoitures += source->nombreVoitures;
+    self->estTrie = (self->tailleTriee == self->nombreVoitures);
+    stats_fusionner(&(self->chaine->stats), &(source->chaine->stats));
+
+    col_abandonnerElements(source, self);
+}
+
+// @brief Récupère l'immatriculation actuelle (la dernière) de la voiture,
+//        retourne false si la voiture n'est pas immatriculée
+static bool voiture_getImmatriculationActuelle(const_Voiture voiture, char *immatriculation)
+{
+    int nbImmatriculations = voi_getNbImmatriculations(voiture);
+    if (nbImmatriculations == 0)
+        return false;
+    voi_getImmatriculation(voiture, nbImmatriculations - 1, immatriculation);
+    return true;
+}
+
+// @brief Retourne les voitures de self dont l'immatriculation actuelle est (garderCommunes)
+//        ou n'est pas (!garderCommunes) celle d'une voiture de autre
+static Collection col_filtrerImmatriculations(const_Collection self, const_Collection autre, bool garderCommunes)
+{
+    char immatriculation[COL_MAX_LEN + 1];
+    TableChaines immatriculations;
+    table_initialiser(&immatriculations);
+    for (Element *element = autre->premier; element != NULL; element = element->suivant)
+    {
+        if (voiture_getImmatriculationActuelle(element->partage->voiture, immatriculation))
+            table_compter(&immatriculations, immatriculation, 1);
+    }
+
+    Collection result = col_creer();
+    for (Element *element = self->premier; element != NULL; element = element->suivant)
+    {
+        bool estCommune = voiture_getImmatriculationActuelle(element->partage->voiture, immatriculation)
+                          && table_getNb(&immatriculations, immatriculation) > 0;
+        if (estCommune == garderCommunes)
+            col_ajouterElementFin(result, element_creer(partage_retenir(element->partage)));
+    }
+    table_detruire(&immatriculations);
+    return result;
+}
+
+// @brief Retourne les voitures de self dont l'immatriculation actuelle n'apparaît pas dans autre
+//        (les voitures sans immatriculation sont conservées). Les voitures sont partagées, pas copiées.
+Collection col_difference(const_Collection self, const_Collection autre)
+{
+    myassert(self != NULL && autre != NULL, "col_difference - Collection is null");
+    return col_filtrerImmatriculations(self, autre, false);
+}
+
+// @brief Retourne les voitures de self dont l'immatriculation actuelle apparaît aussi dans autre
+//        Les voitures sont partagées, pas copiées.
+Collection col_intersection(const_Collection self, const_Collection autre)
+{
+    myassert(self != NULL && autre != NULL, "col_intersection - Collection is null");
+    return col_filtrerImmatriculations(self, autre, true);
+}
+
+/*----------*
+ * statistiques
+ *----------*/
+
+// @brief Retourne l'année de la voiture la plus ancienne
+int col_stat_getAnneeMin(const_Collection self)
+{
+    myassert(self != NULL, "col_stat_getAnneeMin - Collection is null");
+    myassert(self->nombreVoitures > 0, "col_stat_getAnneeMin - Collection is empty");
+    return self->chaine->stats.anneeMin;
+}
+
+// @brief Retourne l'année de la voiture la plus récente
+int col_stat_getAnneeMax(const_Collection self)
+{
+    myassert(self != NULL, "col_stat_getAnneeMax - Collection is null");
+    myassert(self->nombreVoitures > 0, "col_stat_getAnneeMax - Collection is empty");
+    return self->chaine->stats.anneeMax;
+}
+
+// @brief Retourne l'année moyenne des voitures
+double col_stat_getAnneeMoyenne(const_Collection self)
+{
+    myassert(self != NULL, "col_stat_getAnneeMoyenne - Collection is null");
+    myassert(self->nombreVoitures > 0, "col_stat_getAnneeMoyenne - Collection is empty");
+    return (double)self->chaine->stats.sommeAnnees / self->nombreVoitures;
+}
+
+// @brief Retourne la somme des kilométrages des voitures
+long long col_stat_getKilometrageTotal(const_Collection self)
+{
+    myassert(self != NULL, "col_stat_getKilometrageTotal - Collection is null");
+    return self->chaine->stats.kilometrageTotal;
+}
+
+// @brief Retourne le kilométrage moyen des voitures
+double col_stat_getKilometrageMoyen(const_Collection self)
+{
+    myassert(self != NULL, "col_stat_getKilometrageMoyen - Collection is null");
+    myassert(self->nombreVoitures > 0, "col_stat_getKilometrageMoyen - Collection is empty");
+    return (double)self->chaine->stats.kilometrageTotal / self->nombreVoitures;
+}
+
+// @brief Retourne le nombre de voitures de l'année
+int col_stat_getNbVoituresAnnee(const_Collection self, int annee)
+{
+    myassert(self != NULL, "col_stat_getNbVoituresAnnee - Collection is null");
+    return tableAnnees_getNb(&(self->chaine->stats.annees), annee);
+}
+
+// @brief Retourne le nombre de voitures de la marque
+int col_stat_getNbVoituresMarque(const_Collection self, const char *marque)
+{
+    myassert(self != NULL, "col_stat_getNbVoituresMarque - Collection is null");
+    myassert(marque != NULL, "col_stat_getNbVoituresMarque - Brand is null");
+    return table_getNb(&(self->chaine->stats.marques), marque);
+}
+
+/*----------*
+ * statistiques d'ordre
+ *----------*/
+
+// @brief Retourne la clé de la voiture contenue dans l'élément
+static int element_cle(const Element *element, ColCle cle)
+{
+    if (cle == COL_CLE_ANNEE)
+        return voi_getAnnee(element->partage->voiture);
+    return voi_getKilometrage(element->partage->voiture);
+}
+
+// @brief Retourne le k-ième plus petit entier de t (sélection rapide, O(n) en moyenne)
+//        note : t est réordonné
+static int selectionner(int *t, int n, int k)
+{
+    int gauche = 0;
+    int droite = n - 1;
+    while (gauche < droite)
+    {
+        // Partition de Hoare autour de la valeur médiane des extrémités et du milieu
+        int a = t[gauche], b = t[(gauche + droite) / 2], c = t[droite];
+        int pivot = (a < b) ? ((b < c) ? b : (a < c ? c : a)) : ((a < c) ? a : (b < c ? c : b));
+        int i = gauche;
+        int j = droite;
+        while (i <= j)
+        {
+            while (t[i] < pivot)
+                i++;
+            while (t[j] > pivot)
+                j--;
+            if (i <= j)
+            {
+                int temp = t[i];
+                t[i] = t[j];
+                t[j] = temp;
+                i++;
+                j--;
+            }
+        }
+        if (k <= j)
+            droite = j;
+        else if (k >= i)
+            gauche = i;
+        else
+            return t[k];
+    }
+    return t[k];
+}
+
+// @brief Retourne le percentile p (entre 0 et 100) de la clé, selon la méthode du rang le plus proche
+//        Sur une collection triée par année, la valeur est lue directement à sa position
+int col_percentile(const_Collection self, ColCle cle, double p)
+{
+    myassert(self != NULL, "col_percentile - Collection is null");
+    myassert(self->nombreVoitures > 0, "col_percentile - Collection is empty");
+    myassert(p >= 0 && p <= 100, "col_percentile - p must be between 0 and 100");
+
+    // rang (à partir de 1) = plafond(p / 100 * n), au moins 1
+    double rangReel = p / 100 * self->nombreVoitures;
+    int rang = (int)rangReel;
+    if (rang < rangReel)
+        rang++;
+    int pos = rang > 0 ? rang - 1 : 0;
+
+    if (cle == COL_CLE_ANNEE && self->estTrie)
+    {
+        const Element *element;
+        if (pos < (self->nombreVoitures / 2))
+        {
+            element = self->premier;
+            for (int i = 0; i < pos; i++)
+            {
+                element = element->suivant;
+            }
+        }
+        else
+        {
+            element = self->dernier;
+            for (int i = self->nombreVoitures - 1; i > pos; i--)
+            {
+                element = element->precedent;
+            }
+        }
+        return element_cle(element, cle);
+    }
+
+    int *cles = malloc(sizeof(int) * self->nombreVoitures);
+    if (cles == NULL)
+    {
+        fprintf(stderr, "Error:Collection - col_percentile - mem alloc failed");
+        exit(EXIT_FAILURE);
+    }
+    const Element *element = self->premier;
+    for (int i = 0; i < self->nombreVoitures; i++)
+    {
+        cles[i] = element_cle(element, cle);
+        element = element->suivant;
+    }
+    int result = selectionner(cles, self->nombreVoitures, pos);
+    free(cles);
+    return result;
+}
+
+// @brief Rétablit le tas-min (sur la clé) à partir de l'indice i
+static void tas_descendre(const Element **tas, int taille, int i, ColCle cle)
+{
+    while (true)
+    {
+        int plusPetit = i;
+        int gauche = 2 * i + 1;
+        int droite = 2 * i + 2;
+        if (gauche < taille && element_cle(tas[gauche], cle) < element_cle(tas[plusPetit], cle))
+            plusPetit = gauche;
+        if (droite < taille && element_cle(tas[droite], cle) < element_cle(tas[plusPetit], cle))
+            plusPetit = droite;
+        if (plusPetit == i)
+            return;
+        const Element *temp = tas[i];
+        tas[i] = tas[plusPetit];
+        tas[plusPetit] = temp;
+        i = plusPetit;
+    }
+}
+
+// @brief Copie dans out les k voitures de plus grande clé, de la plus grande à la plus petite
+//        Retourne le nombre de voitures copiées (k au plus). Seules ces voitures sont copiées,
+//        la sélection se fait avec un tas de k éléments en O(n log k).
+int col_topK(const_Collection self, ColCle cle, int k, Voiture out[])
+{
+    myassert(self != NULL, "col_topK - Collection is null");
+    myassert(k >= 0, "col_topK - k must be positive");
+    myassert(k == 0 || out != NULL, "col_topK - out is null");
+
+    if (k > self->nombreVoitures)
+        k = self->nombreVoitures;
+
+    // Sur une collection triée par année, les k dernières voitures sont les plus récentes
+    if (cle == COL_CLE_ANNEE && self->estTrie)
+    {
+        const Element *element = self->dernier;
+        for (int i = 0; i < k; i++)
+        {
+            out[i] = voi_creerCopie(element->partage->voiture);
+            element = element->precedent;
+        }
+        return k;
+    }
+
+    const Element **tas = malloc(sizeof(Element *) * (k > 0 ? k : 1));
+    if (tas == NULL)
+    {
+        fprintf(stderr, "Error:Collection - col_topK - mem alloc failed");
+        exit(EXIT_FAILURE);
+    }
+
+    // Le tas-min contient les k plus grandes clés rencontrées, la plus petite à sa racine
+    int taille = 0;
+    const Element *element = self->premier;
+    while (element != NULL && k > 0)
+    {
+        if (taille < k)
+        {
+            tas[taille] = element;
+            taille++;
+            if (taille == k)
+            {
+                for (int i = k / 2 - 1; i >= 0; i--)
+                {
+                    tas_descendre(tas, taille, i, cle);
+                }
+            }
+        }
+        else if (element_cle(element, cle) > element_cle(tas[0], cle))
+        {
+            tas[0] = element;
+            tas_descendre(tas, taille, 0, cle);
+        }
+        element = element->suivant;
+    }
+
+    // On vide le tas : la racine est la plus petite, elle va en fin de tableau
+    for (int i = taille - 1; i >= 0; i--)
+    {
+        out[i] = voi_creerCopie(tas[0]->partage->voiture);
+        tas[0] = tas[i];
+        tas_descendre(tas, i, 0, cle);
+    }
+    free(tas);
+    return taille;
+}
+
+/*----------*
+ * empreinte mémoire et compactage
+ *----------*/
+
+// @brief Ajoute la taille demandée d'un bloc à sa catégorie, et ce que malloc a réservé en plus
+//        (arrondi et en-tête du bloc) à perdu
+//        note : hors glibc, seule la taille demandée est connue
+static void memoire_compter(size_t *categorie, size_t *perdu, void *bloc, size_t demande)
+{
+    *categorie += demande;
+#ifdef __GLIBC__
+    *perdu += malloc_usable_size(bloc) - demande + sizeof(size_t);
+#else
+    (void)bloc;
+    (void)perdu;
+#endif
+}
+
+// @brief Retourne la mémoire utilisée par self : éléments, voitures, chaînes et statistiques,
+//        ainsi que la mémoire réservée mais inutilisée
+//        note : la taille des structures Voiture (opaques) n'est connue qu'avec la glibc,
+//        celle des chaînes est estimée à partir de leurs longueurs
+ColMemoire col_getMemoryUsage(const_Collection self)
+{
+    myassert(self != NULL, "col_getMemoryUsage - Collection is null");
+
+    ColMemoire result = {0, 0, 0, 0, 0, 0};
+    const Chaine *chaine = self->chaine;
+    char tmp[COL_MAX_LEN + 1];
+
+    for (const Element *element = self->premier; element != NULL; element = element->suivant)
+    {
+        if (chaine_trouverZone(chaine, element) == NULL)
+            memoire_compter(&(result.elements), &(result.perdu), (void *)element, sizeof(Element));
+        else
+            result.elements += sizeof(Element);
+
+        VoiturePartagee *partage = element->partage;
+        if (partage->zone == NULL)
+            memoire_compter(&(result.voitures), &(result.perdu), partage, sizeof(VoiturePartagee));
+        else
+            result.voitures += sizeof(VoiturePartagee);
+#ifdef __GLIBC__
+        result.voitures += malloc_usable_size(partage->voiture);
+#endif
+
+        voi_getMarque(partage->voiture, tmp);
+        result.chaines += strlen(tmp) + 1;
+        int nbImmatriculations = voi_getNbImmatriculations(partage->voiture);
+        result.chaines += nbImmatriculations * sizeof(char *);
+        for (int i = 0; i < nbImmatriculations; i++)
+        {
+            voi_getImmatriculation(partage->voiture, i, tmp);
+            result.chaines += strlen(tmp) + 1;
+        }
+    }
+
+    // Les cases des zones qui ne servent plus sont perdues jusqu'au prochain compactage
+    for (int i = 0; i < chaine->nbZones; i++)
+    {
+        const Zone *zone = chaine->zones[i];
+        size_t taille = 0;
+        memoire_compter(&taille, &(result.perdu), (void *)zone, sizeof(Zone) + zone->nbCases * sizeof(Case));
+        result.perdu += taille - zone->nbElements * sizeof(Element) - zone->nbPartages * sizeof(VoiturePartagee);
+    }
+
+    const Statistiques *stats = &(chaine->stats);
+    memoire_compter(&(result.statistiques), &(result.perdu), (void *)self, sizeof(struct CollectionP));
+    memoire_compter(&(result.statistiques), &(result.perdu), (void *)chaine, sizeof(Chaine));
+    if (chaine->zones != NULL)
+        memoire_compter(&(result.statistiques), &(result.perdu), chaine->zones,
+                        chaine->capaciteZones * sizeof(Zone *));
+    if (stats->annees.cases != NULL)
+        memoire_compter(&(result.statistiques), &(result.perdu), stats->annees.cases,
+                        stats->annees.capacite * sizeof(CompteAnnee));
+    if (stats->marques.cases != NULL)
+    {
+        memoire_compter(&(result.statistiques), &(result.perdu), stats->marques.cases,
+                        stats->marques.capacite * sizeof(CompteChaine));
+        for (int i = 0; i < stats->marques.capacite; i++)
+        {
+            if (stats->marques.cases[i].chaine != NULL)
+                memoire_compter(&(result.statistiques), &(result.perdu), stats->marques.cases[i].chaine,
+                                strlen(stats->marques.cases[i].chaine) + 1);
+        }
+    }
+
+    result.total = result.elements + result.voitures + result.chaines + result.statistiques + result.perdu;
+    return result;
+}
+
+// @brief Recopie les éléments de self dans une zone contiguë, dans l'ordre de la liste
+//        Les voitures que self est seule à utiliser sont recopiées (voi_creerCopie) dans
+//        l'ordre de la liste, leur bloc partagé est rangé dans la case de leur élément.
+//        Les voitures partagées avec d'autres collections restent en place.
+//        La mémoire libérée est ensuite rendue au système (glibc).
+void col_compacter(Collection self)
+{
+    myassert(self != NULL, "col_compacter - Collection is null");
+
+    col_detacher(self);
+
+    if (self->nombreVoitures > 0)
+    {
+        int nbCases = self->nombreVoitures;
+        Zone *zone = malloc(sizeof(Zone) + nbCases * sizeof(Case));
+        // Dans le cas ou la mémoire n'est pas allouée correctement, le programme échoue
+        if (zone == NULL)
+        {
+            fprintf(stderr, "Error:Collection - col_compacter - mem alloc failed");
+            exit(EXIT_FAILURE);
+        }
+        zone->nbElements = nbCases;
+        zone->nbPartages = 0;
+        zone->nbCases = nbCases;
+
+        // Toutes les copies sont faites avant les libérations, pour qu'elles se suivent en mémoire
+        Element *ancien = self->premier;
+        for (int i = 0; i < nbCases; i++)
+        {
+            Case *nouvelle = &(zone->cases[i]);
+            if (ancien->partage->nbReferences == 1)
+            {
+                nouvelle->partage.voiture = voi_creerCopie(ancien->partage->voiture);
+                nouvelle->partage.nbReferences = 1;
+                nouvelle->partage.zone = zone;
+                nouvelle->element.partage = &(nouvelle->partage);
+                zone->nbPartages++;
+            }
+            else
+            {
+                nouvelle->element.partage = partage_retenir(ancien->partage);
+            }
+            nouvelle->element.precedent = (i > 0) ? &(zone->cases[i - 1].element) : NULL;
+            nouvelle->element.suivant = (i < nbCases - 1) ? &(zone->cases[i + 1].element) : NULL;
+            ancien = ancien->suivant;
+        }
+
+        // Les anciens éléments sont détruits, les statistiques ne changent pas
+        ancien = self->premier;
+        while (ancien != NULL)
+        {
+            Element *suivant = ancien->suivant;
+            element_detruire(self->chaine, ancien);
+            ancien = suivant;
+        }
+
+        chaine_ajouterZone(self->chaine, zone);
+        self->premier = &(zone->cases[0].element);
+        self->dernier = &(zone->cases[nbCases - 1].element);
+    }
+
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+/*----------*
+ * méthode secondaire d'affichage
+ *----------*/
+
+// @brief Affiche les éléments de la collection et de toutes les voitures qu'elle contient
+void col_afficher(const_Collection self)
+{
+    printf("Collection :\n");
+    printf("\tEst trié : %s\n", self->estTrie ? "Vrai" : "Faux");
+    printf("\tNombre de voitures : %d\n", self->nombreVoitures);
+
+    Element *elementSuivant = self->premier;
+    while (elementSuivant != NULL)
+    {
+        voi_afficher(elementSuivant->partage->voiture);
+        elementSuivant = elementSuivant->suivant;
+    }
+}
+
+/*----------*
+ * entrées-sorties fichiers
+ * note : le paramètre est un fichier déjà ouvert
+ *----------*/
+
+// @brief Ecrit les données d'une collection dans un fichier
+void col_ecrireFichier(const_Collection self, FILE *fd)
+{
+    if (self == NULL || fd == NULL)
+    {
+        fprintf(stderr, "Error:Collection - col_ecrireFichier - collection or file is null");
+        exit(EXIT_FAILURE);
+    }
+
+    fseek(fd, 0, SEEK_SET);
+    fwrite(&(self->estTrie), sizeof(bool), 1, fd);
+    fwrite(&(self->nombreVoitures), sizeof(int), 1, fd);
+
+    Element *element = self->premier;
+
+    while (element != NULL)
+    {
+        voi_ecrireFichier(element->partage->voiture, fd);
+        element = element->suivant;
+    }
+}
+
+static const char MAGIC_COMPRESSE[4];
+static void col_lireFichierCompresse(Collection self, FILE *fd);
+
+// @brief Remplie la collection self avec les données stockés dans le fichier fd
+//        (format brut de col_ecrireFichier ou format de col_ecrireFichierCompresse)
+void col_lireFichier(Collection self, FILE *fd)
+{
+    if (self == NULL || fd == NULL)
+    {
+        fprintf(stderr, "Error:Collection - col_lireFichier - collection or file is null");
+        exit(EXIT_FAILURE);
+    }
+
+    col_vider(self); // On vide la collection pour pouvoir l'écraser
+    fseek(fd, 0, SEEK_SET);
+
+    // Le format brut commence par un booléen, le format compressé par son en-tête
+    char magic[sizeof(MAGIC_COMPRESSE)];
+    if (fread(magic, sizeof(magic), 1, fd) == 1 && memcmp(magic, MAGIC_COMPRESSE, sizeof(magic)) == 0)
+    {
+        col_lireFichierCompresse(self, fd);
+        return;
+    }
+    fseek(fd, 0, SEEK_SET);
+
+    // L'indicateur de tri du fichier n'est pas repris : le début trié est recalculé à la lecture
+    bool estTrie;
+    int nombreVoitures;
+    if (fread(&estTrie, sizeof(bool), 1, fd) != 1 || fread(&nombreVoitures, sizeof(int), 1, fd) != 1
+        || nombreVoitures < 0)
+    {
+        fprintf(stderr, "Error:Collection - col_lireFichier - invalid header");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < nombreVoitures; i++)
+    {
+        // voi_creerFromFichier ne signale pas un enregistrement incomplet :
+        // une lecture qui a atteint la fin du fichier en a rencontré un
+        Voiture voiture = voi_creerFromFichier(fd);
+        if (feof(fd) || ferror(fd))
+        {
+            voi_detruire(&voiture);
+            fprintf(stderr, "Error:Collection - col_lireFichier - truncated file");
+            exit(EXIT_FAILURE);
+        }
+        col_ajouterElementFin(self, element_creer(partage_creer(voiture)));
+    }
+}
+
+/*----------*
+ * entrées-sorties fichiers parallèles
+ * format : "COLB", estTrie, nombreVoitures, nbBlocs,
+ *          puis pour chaque bloc son offset, sa taille et son nombre de voitures,
+ *          puis le contenu des blocs (voitures encodées comme au format compressé,
+ *          chaque bloc ayant son propre dictionnaire de marques)
+ *----------*/
+
+static const char MAGIC_BLOCS[4] = {'C', 'O', 'L', 'B'};
+
+// Bloc de voitures traité par un thread
+typedef struct Bloc
+{
+    Element *premier;
+    Element *dernier;
+    int nbVoitures;
+    char *tampon;
+    size_t taille;
+    int64_t offset;
+    int descripteur;
+    Statistiques stats;
+} Bloc;
+
+// Les statistiques globales du module Voiture ne sont pas protégées : les threads de lecture
+// décodent leurs voitures en parallèle, seul l'appel à voi_creer est sérialisé
+static pthread_mutex_t verrouVoiture = PTHREAD_MUTEX_INITIALIZER;
+
+static void compresse_ecrireVoitures(const Element *premier, int nombreVoitures, FILE *fd);
+static void compresse_lireVoitures(FILE *fd, uint64_t nombreVoitures, pthread_mutex_t *verrou,
+                                   void (*ajouter)(void *cible, Voiture voiture), void *cible);
+
+// @brief Encode les voitures du bloc dans son propre tampon mémoire
+static void *bloc_ecrire(void *arg)
+{
+    Bloc *bloc = arg;
+    FILE *flux = open_memstream(&(bloc->tampon), &(bloc->taille));
+    if (flux == NULL)
+    {
+        fprintf(stderr, "Error:Collection - bloc_ecrire - open_memstream failed");
+        exit(EXIT_FAILURE);
+    }
+
+    compresse_ecrireVoitures(bloc->premier, bloc->nbVoitures, flux);
+    fclose(flux);
+    return NULL;
+}
+
+// @brief Ajoute une voiture décodée à la fin de la sous-liste du bloc
+static void bloc_ajouterVoiture(void *cible, Voiture voiture)
+{
+    Bloc *bloc = cible;
+    Element *element = element_creer(partage_creer(voiture));
+    stats_ajouter(&(bloc->stats), voiture);
+    element->precedent = bloc->dernier;
+    if (bloc->dernier == NULL)
+        bloc->premier = element;
+    else
+        bloc->dernier->suivant = element;
+    bloc->dernier = element;
+}
+
+// @brief Lit le bloc depuis le fichier et le décode en une sous-liste indépendante
+static void *bloc_lire(void *arg)
+{
+    Bloc *bloc = arg;
+    bloc->tampon = malloc(bloc->taille > 0 ? bloc->taille : 1);
+    if (bloc->tampon == NULL)
+    {
+        fprintf(stderr, "Error:Collection - bloc_lire - mem alloc failed");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t lu = 0;
+    while (lu < bloc->taille)
+    {
+        ssize_t n = pread(bloc->descripteur, bloc->tampon + lu, bloc->taille - lu, bloc->offset + lu);
+        if (n <= 0)
+        {
+            fprintf(stderr, "Error:Collection - bloc_lire - truncated file");
+            exit(EXIT_FAILURE);
+        }
+        lu += n;
+    }
+
+    FILE *flux = fmemopen(bloc->tampon, bloc->taille > 0 ? bloc->taille : 1, "r");
+    if (flux == NULL)
+    {
+        fprintf(stderr, "Error:Collection - bloc_lire - fmemopen failed");
+        exit(EXIT_FAILURE);
+    }
+
+    bloc->premier = NULL;
+    bloc->dernier = NULL;
+    stats_initialiser(&(bloc->stats));
+    compresse_lireVoitures(flux, bloc->nbVoitures, &verrouVoiture, bloc_ajouterVoiture, bloc);
+    fclose(flux);
+    free(bloc->tampon);
+    return NULL;
+}
+
+// @brief Exécute traitement sur chaque bloc, chacun dans son thread
+static void blocs_executer(Bloc *blocs, int nbBlocs, void *(*traitement)(void *))
+{
+    pthread_t *threads = malloc(sizeof(pthread_t) * (nbBlocs > 0 ? nbBlocs : 1));
+    if (threads == NULL)
+    {
+        fprintf(stderr, "Error:Collection - blocs_executer - mem alloc failed");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < nbBlocs; i++)
+    {
+        if (pthread_create(&(threads[i]), NULL, traitement, &(blocs[i])) != 0)
+        {
+            fprintf(stderr, "Error:Collection - blocs_executer - pthread_create failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < nbBlocs; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+}
+
+// @brief Ecrit la collection dans le format par blocs, chaque bloc étant encodé par un thread
+void col_ecrireFichierParallele(const_Collection self, FILE *fd, int nbThreads)
+{
+    if (self == NULL || fd == NULL)
+    {
+        fprintf(stderr, "Error:Collection - col_ecrireFichierParallele - collection or file is null");
+        exit(EXIT_FAILURE);
+    }
+    myassert(nbThreads > 0, "col_ecrireFichierParallele - nbThreads must be positive");
+
+    int nbBlocs = self->nombreVoitures < nbThreads ? self->nombreVoitures : nbThreads;
+    Bloc *blocs = calloc(nbBlocs > 0 ? nbBlocs : 1, sizeof(Bloc));
+    if (blocs == NULL)
+    {
+        fprintf(stderr, "Error:Collection - col_ecrireFichierParallele - mem alloc failed");
+        exit(EXIT_FAILURE);
+    }
+
+    // Découpage de la liste en blocs de tailles égales (à une voiture près)
+    Element *element = self->premier;
+    for (int i = 0; i < nbBlocs; i++)
+    {
+        blocs[i].premier = element;
+        blocs[i].nbVoitures = self->nombreVoitures / nbBlocs + (i < self->nombreVoitures % nbBlocs ? 1 : 0);
+        for (int j = 0; j < blocs[i].nbVoitures; j++)
+        {
+            element = element->suivant;
+        }
+    }
+
+    blocs_executer(blocs, nbBlocs, bloc_ecrire);
+
+    // L'en-tête et la table des blocs précèdent les données
+    int64_t offset = sizeof(MAGIC_BLOCS) + sizeof(bool) + 2 * sizeof(int)
+                     + (int64_t)nbBlocs * (2 * sizeof(int64_t) + sizeof(int));
+    fseek(fd, 0, SEEK_SET);
+    fwrite(MAGIC_BLOCS, sizeof(MAGIC_BLOCS), 1, fd);
+    fwrite(&(self->estTrie), sizeof(bool), 1, fd);
+    fwrite(&(self->nombreVoitures), sizeof(int), 1, fd);
+    fwrite(&nbBlocs, sizeof(int), 1, fd);
+    for (int i = 0; i < nbBlocs; i++)
+    {
+        int64_t taille = blocs[i].taille;
+        fwrite(&offset, sizeof(int64_t), 1, fd);
+        fwrite(&taille, sizeof(int64_t), 1, fd);
+        fwrite(&(blocs[i].nbVoitures), sizeof(int), 1, fd);
+        offset += taille;
+    }
+    for (int i = 0; i < nbBlocs; i++)
+    {
+        fwrite(blocs[i].tampon, 1, blocs[i].taille, fd);
+        free(blocs[i].tampon);
+    }
+    fflush(fd);
+    free(blocs);
+}
+
+// @brief Remplie la collection self à partir d'un fichier écrit par col_ecrireFichierParallele,
+//        chaque bloc étant décodé par un thread puis raccordé dans l'ordre
+void col_lireFichierParallele(Collection self, FILE *fd, int nbThreads)
+{
+    if (self == NULL || fd == NULL)
+    {
+        fprintf(stderr, "Error:Collection - col_lireFichierParallele - collection or file is null");
+        exit(EXIT_FAILURE);
+    }
+    myassert(nbThreads > 0, "col_lireFichierParallele - nbThreads must be positive");
+
+    col_vider(self); // On vide la collection pour pouvoir l'écraser
+    fseek(fd, 0, SEEK_SET);
+
+    char magic[sizeof(MAGIC_BLOCS)];
+    int nbBlocs = 0;
+    bool estTrie = true;
+    int nombreVoitures = 0;
+    if (fread(magic, sizeof(magic), 1, fd) != 1 || memcmp(magic, MAGIC_BLOCS, sizeof(magic)) != 0
+        || fread(&estTrie, sizeof(bool), 1, fd) != 1
+        || fread(&nombreVoitures, sizeof(int), 1, fd) != 1
+        || fread(&nbBlocs, sizeof(int), 1, fd) != 1 || nbBlocs < 0)
+    {
+        fprintf(stderr, "Error:Collection - col_lireFichierParallele - invalid header");
+        exit(EXIT_FAILURE);
+    }
+
+    Bloc *blocs = calloc(nbBlocs > 0 ? nbBlocs : 1, sizeof(Bloc));
+    if (blocs == NULL)
+    {
+        fprintf(stderr, "Error:Collection - col_lireFichierParallele - mem alloc failed");
+        exit(EXIT_FAILURE);
+    }
+    int64_t total = 0; // ne peut pas déborder : au plus INT32_MAX blocs de INT32_MAX voitures
+    for (int i = 0; i < nbBlocs; i++)
+    {
+        int64_t taille;
+        if (fread(&(blocs[i].offset), sizeof(int64_t), 1, fd) != 1
+            || fread(&taille, sizeof(int64_t), 1, fd) != 1
+            || fread(&(blocs[i].nbVoitures), sizeof(int), 1, fd) != 1
+            || taille < 0 || blocs[i].nbVoitures < 0)
+        {
+            fprintf(stderr, "Error:Collection - col_lireFichierParallele - invalid block table");
+            exit(EXIT_FAILURE);
+        }
+        blocs[i].taille = taille;
+        blocs[i].descripteur = fileno(fd);
+        total += blocs[i].nbVoitures;
+    }
+    if (total != nombreVoitures)
+    {
+        fprintf(stderr, "Error:Collection - col_lireFichierParallele - invalid block table");
+        exit(EXIT_FAILURE);
+    }
+
+    // On ne lance jamais plus de nbThreads threads à la fois
+    for (int debut = 0; debut < nbBlocs; debut += nbThreads)
+    {
+        int nb = nbBlocs - debut < nbThreads ? nbBlocs - debut : nbThreads;
+        blocs_executer(blocs + debut, nb, bloc_lire);
+    }
+
+    // Raccordement des sous-listes dans l'ordre du fichier
+    for (int i = 0; i < nbBlocs; i++)
+    {
+        stats_fusionner(&(self->chaine->stats), &(blocs[i].stats));
+        stats_detruire(&(blocs[i].stats));
+        if (blocs[i].premier == NULL)
+            continue;
+        blocs[i].premier->precedent = self->dernier;
+        if (self->dernier == NULL)
+            self->premier = blocs[i].premier;
+        else
+            self->dernier->suivant = blocs[i].premier;
+        self->dernier = blocs[i].dernier;
+    }
+    self->nombreVoitures = nombreVoitures;
+
+    // Le début trié est recalculé plutôt que repris de l'en-tête
+    self->tailleTriee = 0;
+    for (Element *element = self->premier; element != NULL; element = element->suivant)
+    {
+        if (element->precedent != NULL
+            && voi_getAnnee(element->precedent->partage->voiture) > voi_getAnnee(element->partage->voiture))
+            break;
+        self->tailleTriee++;
+    }
+    self->estTrie = (self->tailleTriee == self->nombreVoitures);
+    free(blocs);
+}
+
+
+/*----------*
+ * entrées-sorties fichiers compressées
+ * format : "COLZ", estTrie, varint nombreVoitures, puis pour chaque voiture :
+ *          - marque : indice varint dans le dictionnaire, un indice égal à la taille
+ *            du dictionnaire introduit une nouvelle marque (varint longueur + octets)
+ *          - année : écart zigzag-varint avec la voiture précédente (petit si estTrie)
+ *          - kilométrage : zigzag-varint
+ *          - immatriculations : varint nombre, puis pour chacune un octet de type suivi
+ *            soit de 4 octets (format "AB 123 CD" empaqueté), soit de la chaîne brute
+ * Le format se décode au fil de l'eau, sans charger le fichier en mémoire.
+ *----------*/
+
+static const char MAGIC_COMPRESSE[4] = {'C', 'O', 'L', 'Z'};
+
+#define IMMATRICULATION_EMPAQUETEE 0
+#define IMMATRICULATION_BRUTE 1
+
+static void varint_ecrire(uint64_t valeur, FILE *fd)
+{
+    while (valeur >= 0x80)
+    {
+        fputc((int)(valeur & 0x7F) | 0x80, fd);
+        valeur >>= 7;
+    }
+    fputc((int)valeur, fd);
+}
+
+static uint64_t varint_lire(FILE *fd)
+{
+    uint64_t valeur = 0;
+    for (int decalage = 0; decalage < 64; decalage += 7)
+    {
+        int octet = fgetc(fd);
+        if (octet == EOF)
+        {
+            fprintf(stderr, "Error:Collection - varint_lire - truncated file");
+            exit(EXIT_FAILURE);
+        }
+        valeur |= (uint64_t)(octet & 0x7F) << decalage;
+        if ((octet & 0x80) == 0)
+            return valeur;
+    }
+    fprintf(stderr, "Error:Collection - varint_lire - invalid varint");
+    exit(EXIT_FAILURE);
+}
+
+// zigzag : les petites valeurs négatives restent courtes
+static void zigzag_ecrire(int64_t valeur, FILE *fd)
+{
+    varint_ecrire(((uint64_t)valeur << 1) ^ (uint64_t)(valeur >> 63), fd);
+}
+
+static int64_t zigzag_lire(FILE *fd)
+{
+    uint64_t valeur = varint_lire(fd);
+    return (int64_t)(valeur >> 1) ^ -(int64_t)(valeur & 1);
+}
+
+static void chaine_ecrire(const char *chaine, FILE *fd)
+{
+    size_t longueur = strlen(chaine);
+    varint_ecrire(longueur, fd);
+    fwrite(chaine, 1, longueur, fd);
+}
+
+// @brief Lit une chaîne dans un tableau d'au moins COL_MAX_LEN + 1 caractères
+static void chaine_lire(char *chaine, FILE *fd)
+{
+    uint64_t longueur = varint_lire(fd);
+    if (longueur > COL_MAX_LEN || fread(chaine, 1, longueur, fd) != longueur)
+    {
+        fprintf(stderr, "Error:Collection - chaine_lire - invalid string");
+        exit(EXIT_FAILURE);
+    }
+    chaine[longueur] = '\0';
+}
+
+static bool estLettre(char c)
+{
+    return c >= 'A' && c <= 'Z';
+}
+
+static bool estChiffre(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// @brief Ecrit une immatriculation, empaquetée sur 4 octets si elle suit le format "AB 123 CD"
+static void immatriculation_ecrire(const char *immatriculation, FILE *fd)
+{
+    const char *s = immatriculation;
+    if (strlen(s) == 9 && estLettre(s[0]) && estLettre(s[1]) && s[2] == ' '
+        && estChiffre(s[3]) && estChiffre(s[4]) && estChiffre(s[5]) && s[6] == ' '
+        && estLettre(s[7]) && estLettre(s[8]))
+    {
+        uint32_t lettres = (((s[0] - 'A') * 26 + (s[1] - 'A')) * 26 + (s[7] - 'A')) * 26 + (s[8] - 'A');
+        uint32_t paquet = lettres * 1000 + (s[3] - '0') * 100 + (s[4] - '0') * 10 + (s[5] - '0');
+        fputc(IMMATRICULATION_EMPAQUETEE, fd);
+        for (int i = 0; i < 4; i++)
+        {
+            fputc((paquet >> (8 * i)) & 0xFF, fd);
+        }
     }
     else
     {
-        aSupprimer = self->premier;
-        for (int i = 0; i < pos; i++)
+        fputc(IMMATRICULATION_BRUTE, fd);
+        chaine_ecrire(s, fd);
+    }
+}
+
+// @brief Lit une immatriculation dans un tableau d'au moins COL_MAX_LEN + 1 caractères
+static void immatriculation_lire(char *immatriculation, FILE *fd)
+{
+    int type = fgetc(fd);
+    if (type == IMMATRICULATION_BRUTE)
+    {
+        chaine_lire(immatriculation, fd);
+        return;
+    }
+    if (type != IMMATRICULATION_EMPAQUETEE)
+    {
+        fprintf(stderr, "Error:Collection - immatriculation_lire - invalid plate");
+        exit(EXIT_FAILURE);
+    }
+
+    uint32_t paquet = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        int octet = fgetc(fd);
+        if (octet == EOF)
+        {
+            fprintf(stderr, "Error:Collection - immatriculation_lire - truncated file");
+            exit(EXIT_FAILURE);
+        }
+        paquet |= (uint32_t)octet << (8 * i);
+    }
+    uint32_t chiffres = paquet % 1000;
+    uint32_t lettres = paquet / 1000;
+    if (lettres >= 26 * 26 * 26 * 26)
+    {
+        fprintf(stderr, "Error:Collection - immatriculation_lire - invalid plate");
+        exit(EXIT_FAILURE);
+    }
+    immatriculation[8] = 'A' + lettres % 26;
+    lettres /= 26;
+    immatriculation[7] = 'A' + lettres % 26;
+    lettres /= 26;
+    immatriculation[1] = 'A' + lettres % 26;
+    immatriculation[0] = 'A' + lettres / 26;
+    immatriculation[2] = ' ';
+    immatriculation[3] = '0' + chiffres / 100;
+    immatriculation[4] = '0' + (chiffres / 10) % 10;
+    immatriculation[5] = '0' + chiffres % 10;
+    immatriculation[6] = ' ';
+    immatriculation[9] = '\0';
+}
+
+// Dictionnaire des marques rencontrées, dans leur ordre d'apparition
+typedef struct Dictionnaire
+{
+    char **marques;
+    int nbMarques;
+    int capacite;
+} Dictionnaire;
+
+// @brief Retourne l'indice de la marque, ou nbMarques si elle est absente
+static int dictionnaire_chercher(const Dictionnaire *dictionnaire, const char *marque)
+{
+    int i = 0;
+    while (i < dictionnaire->nbMarques && strcmp(dictionnaire->marques[i], marque) != 0)
+    {
+        i++;
+    }
+    return i;
+}
+
+static void dictionnaire_ajouter(Dictionnaire *dictionnaire, const char *marque)
+{
+    if (dictionnaire->nbMarques == dictionnaire->capacite)
+    {
+        dictionnaire->capacite = dictionnaire->capacite == 0 ? 16 : 2 * dictionnaire->capacite;
+        dictionnaire->marques = realloc(dictionnaire->marques, sizeof(char *) * dictionnaire->capacite);
+        if (dictionnaire->marques == NULL)
+        {
+            fprintf(stderr, "Error:Collection - dictionnaire_ajouter - mem alloc failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+    char *copie = malloc(strlen(marque) + 1);
+    if (copie == NULL)
+    {
+        fprintf(stderr, "Error:Collection - dictionnaire_ajouter - mem alloc failed");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(copie, marque);
+    dictionnaire->marques[dictionnaire->nbMarques++] = copie;
+}
+
+static void dictionnaire_vider(Dictionnaire *dictionnaire)
+{
+    for (int i = 0; i < dictionnaire->nbMarques; i++)
+    {
+        free(dictionnaire->marques[i]);
+    }
+    free(dictionnaire->marques);
+}
+
+// @brief Ecrit les nombreVoitures voitures qui suivent premier (inclus) au format compressé,
+//        avec un dictionnaire de marques propre à cet appel
+static void compresse_ecrireVoitures(const Element *premier, int nombreVoitures, FILE *fd)
+{
+    Dictionnaire dictionnaire = {NULL, 0, 0};
+    char tampon[COL_MAX_LEN + 1];
+    int anneePrecedente = 0;
+
+    const Element *element = premier;
+    for (int n = 0; n < nombreVoitures; n++)
+    {
+        const_Voiture voiture = element->partage->voiture;
+
+        voi_getMarque(voiture, tampon);
+        int indice = dictionnaire_chercher(&dictionnaire, tampon);
+        varint_ecrire(indice, fd);
+        if (indice == dictionnaire.nbMarques)
+        {
+            chaine_ecrire(tampon, fd);
+            dictionnaire_ajouter(&dictionnaire, tampon);
+        }
+
+        int annee = voi_getAnnee(voiture);
+        zigzag_ecrire((int64_t)annee - anneePrecedente, fd);
+        anneePrecedente = annee;
+
+        zigzag_ecrire(voi_getKilometrage(voiture), fd);
+
+        int nbImmatriculations = voi_getNbImmatriculations(voiture);
+        varint_ecrire(nbImmatriculations, fd);
+        for (int i = 0; i < nbImmatriculations; i++)
+        {
+            voi_getImmatriculation(voiture, i, tampon);
+            immatriculation_ecrire(tampon, fd);
+        }
+
+        element = element->suivant;
+    }
+    dictionnaire_vider(&dictionnaire);
+}
+
+// @brief Ecrit les données d'une collection dans un fichier au format compressé
+void col_ecrireFichierCompresse(const_Collection self, FILE *fd)
+{
+    if (self == NULL || fd == NULL)
+    {
+        fprintf(stderr, "Error:Collection - col_ecrireFichierCompresse - collection or file is null");
+        exit(EXIT_FAILURE);
+    }
+
+    fseek(fd, 0, SEEK_SET);
+    fwrite(MAGIC_COMPRESSE, sizeof(MAGIC_COMPRESSE), 1, fd);
+    fputc(self->estTrie ? 1 : 0, fd);
+    varint_ecrire(self->nombreVoitures, fd);
+    compresse_ecrireVoitures(self->premier, self->nombreVoitures, fd);
+}
+
+// @brief Décode nombreVoitures voitures au format compressé et les passe une à une à ajouter
+//        Si verrou n'est pas NULL, il n'est pris que pendant voi_creer : le décodage peut
+//        alors se faire dans plusieurs threads à la fois
+static void compresse_lireVoitures(FILE *fd, uint64_t nombreVoitures, pthread_mutex_t *verrou,
+                                   void (*ajouter)(void *cible, Voiture voiture), void *cible)
+{
+    Dictionnaire dictionnaire = {NULL, 0, 0};
+    char marque[COL_MAX_LEN + 1];
+    char *immatriculations[COL_MAX_LEN];
+    int nbTampons = 0; // tampons d'immatriculation alloués, réutilisés d'une voiture à l'autre
+    int annee = 0;
+
+    for (uint64_t n = 0; n < nombreVoitures; n++)
+    {
+        uint64_t indice = varint_lire(fd);
+        if (indice > (uint64_t)dictionnaire.nbMarques)
+        {
+            fprintf(stderr, "Error:Collection - compresse_lireVoitures - invalid brand");
+            exit(EXIT_FAILURE);
+        }
+        if (indice == (uint64_t)dictionnaire.nbMarques)
+        {
+            chaine_lire(marque, fd);
+            dictionnaire_ajouter(&dictionnaire, marque);
+        }
+
+        // L'écart est borné avant l'addition, qui ne peut donc pas déborder
+        int64_t ecartAnnee = zigzag_lire(fd);
+        int64_t kilometrage = zigzag_lire(fd);
+        if (ecartAnnee > (int64_t)INT32_MAX - annee || ecartAnnee < (int64_t)INT32_MIN - annee
+            || kilometrage < INT32_MIN || kilometrage > INT32_MAX)
+        {
+            fprintf(stderr, "Error:Collection - compresse_lireVoitures - invalid value");
+            exit(EXIT_FAILURE);
+        }
+        annee += (int)ecartAnnee;
+
+        uint64_t nbImmatriculations = varint_lire(fd);
+        if (nbImmatriculations > COL_MAX_LEN)
+        {
+            fprintf(stderr, "Error:Collection - compresse_lireVoitures - too many plates");
+            exit(EXIT_FAILURE);
+        }
+        for (uint64_t i = 0; i < nbImmatriculations; i++)
+        {
+            if ((int)i == nbTampons)
+            {
+                immatriculations[nbTampons] = malloc(COL_MAX_LEN + 1);
+                if (immatriculations[nbTampons] == NULL)
+                {
+                    fprintf(stderr, "Error:Collection - compresse_lireVoitures - mem alloc failed");
+                    exit(EXIT_FAILURE);
+                }
+                nbTampons++;
+            }
+            immatriculation_lire(immatriculations[i], fd);
+        }
+
+        if (verrou != NULL)
+            pthread_mutex_lock(verrou);
+        Voiture voiture = voi_creer(dictionnaire.marques[indice], annee, (int)kilometrage,
+                                    (int)nbImmatriculations, (const char **)immatriculations);
+        if (verrou != NULL)
+            pthread_mutex_unlock(verrou);
+        ajouter(cible, voiture);
+    }
+
+    for (int i = 0; i < nbTampons; i++)
+    {
+        free(immatriculations[i]);
+    }
+    dictionnaire_vider(&dictionnaire);
+}
+
+static void col_ajouterVoitureLue(void *cible, Voiture voiture)
+{
+    col_ajouterElementFin(cible, element_creer(partage_creer(voiture)));
+}
+
+// @brief Remplie la collection self à partir du format compressé, voiture par voiture
+//        note : l'en-tête "COLZ" a déjà été lu
+static void col_lireFichierCompresse(Collection self, FILE *fd)
+{
+    int estTrie = fgetc(fd);
+    uint64_t nombreVoitures = varint_lire(fd);
+    if (estTrie == EOF || nombreVoitures > INT32_MAX)
+    {
+        fprintf(stderr, "Error:Collection - col_lireFichierCompresse - invalid header");
+        exit(EXIT_FAILURE);
+    }
+    compresse_lireVoitures(fd, nombreVoitures, NULL, col_ajouterVoitureLue, self);
+}
+
+
+/*----------*
+ * import / export CSV
+ * une voiture par ligne : marque,annee,kilometrage[,immatriculation...]
+ * l'export commence par un en-tête, ignoré à l'import s'il est la première ligne non vide
+ * les champs peuvent être entre guillemets, un champ de plus de COL_MAX_LEN caractères est rejeté
+ * note : contrairement aux autres formats, la lecture et l'écriture se font
+ *        à la position courante du fichier
+ *----------*/
+
+// taille des lectures, un enregistrement plus long agrandit le tampon
+#define TAILLE_TAMPON_CSV (1024 * 1024)
+
+static const char EN_TETE_CSV[] = "marque,annee,kilometrage,immatriculations";
+
+// @brief Ecrit un champ, entre guillemets s'il contient un caractère spécial
+static void csv_ecrireChamp(const char *champ, FILE *fd)
+{
+    if (strpbrk(champ, ",\"\r\n") == NULL)
+    {
+        fputs(champ, fd);
+        return;
+    }
+    fputc('"', fd);
+    for (const char *c = champ; *c != '\0'; c++)
+    {
+        if (*c == '"')
+            fputc('"', fd);
+        fputc(*c, fd);
+    }
+    fputc('"', fd);
+}
+
+// @brief Ecrit les voitures de la collection au format CSV, précédées de l'en-tête
+void col_exporterCSV(const_Collection self, FILE *fd)
+{
+    if (self == NULL || fd == NULL)
+    {
+        fprintf(stderr, "Error:Collection - col_exporterCSV - collection or file is null");
+        exit(EXIT_FAILURE);
+    }
+
+    char tampon[COL_MAX_LEN + 1];
+    fprintf(fd, "%s\n", EN_TETE_CSV);
+    for (const Element *element = self->premier; element != NULL; element = element->suivant)
+    {
+        const_Voiture voiture = element->partage->voiture;
+        voi_getMarque(voiture, tampon);
+        csv_ecrireChamp(tampon, fd);
+        fprintf(fd, ",%d,%d", voi_getAnnee(voiture), voi_getKilometrage(voiture));
+        for (int i = 0; i < voi_getNbImmatriculations(voiture); i++)
+        {
+            voi_getImmatriculation(voiture, i, tampon);
+            fputc(',', fd);
+            csv_ecrireChamp(tampon, fd);
+        }
+        fputc('\n', fd);
+    }
+}
+
+// @brief Découpe en place l'enregistrement [debut, fin[ en champs terminés par '\0'
+//        (fin doit être accessible en écriture). Retourne le nombre de champs.
+static int csv_decouper(char *debut, char *fin, char ***pchamps, int *pcapacite)
+{
+    int nbChamps = 0;
+    char *lecture = debut;
+    while (true)
+    {
+        if (nbChamps == *pcapacite)
         {
-            aSupprimer = aSupprimer->suivant;
+            *pcapacite = (*pcapacite == 0) ? 16 : 2 * (*pcapacite);
+            *pchamps = realloc(*pchamps, sizeof(char *) * (*pcapacite));
+            if (*pchamps == NULL)
+            {
+                fprintf(stderr, "Error:Collection - csv_decouper - mem alloc failed");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        // Le champ est réécrit sur place, sans ses guillemets
+        char *ecriture = lecture;
+        (*pchamps)[nbChamps] = ecriture;
+        nbChamps++;
+        if (lecture < fin && *lecture == '"')
+        {
+            lecture++;
+            while (lecture < fin)
+            {
+                if (*lecture != '"')
+                {
+                    *ecriture++ = *lecture++;
+                }
+                else if (lecture + 1 < fin && lecture[1] == '"')
+                {
+                    *ecriture++ = '"';
+                    lecture += 2;
+                }
+                else
+                {
+                    lecture++;
+                    break;
+                }
+            }
+        }
+        while (lecture < fin && *lecture != ',')
+        {
+            *ecriture++ = *lecture++;
         }
-        aSupprimer->suivant->precedent = aSupprimer->precedent;
-        aSupprimer->precedent->suivant = aSupprimer->suivant;
-        voi_detruire(&(aSupprimer->voiture));
-        free(aSupprimer);
+
+        bool estDernier = (lecture == fin);
+        *ecriture = '\0';
+        if (estDernier)
+            return nbChamps;
+        lecture++;
     }
-    self->nombreVoitures--;
 }
 
-// @brief Supprime la voiture en [pos]
-void col_supprVoitureAvecTri(Collection self, int pos)
+// @brief Lit un entier décimal, le programme échoue si le champ n'en est pas un
+static int csv_lireEntier(const char *champ, int numeroLigne)
 {
-    // On remarque que l'on utilise le même algorithme pour supprimer une voiture avec ou sans tri,
-    // On utilise donc la même fonction
-    col_supprVoitureSansTri(self, pos);
+    char *fin;
+    long valeur = strtol(champ, &fin, 10);
+    if (fin == champ || *fin != '\0' || valeur < INT32_MIN || valeur > INT32_MAX)
+    {
+        fprintf(stderr, "Error:Collection - col_importerCSV - line %d : invalid number \"%s\"", numeroLigne, champ);
+        exit(EXIT_FAILURE);
+    }
+    return (int)valeur;
 }
 
-// @brief Tri la collection self en utilisant l'algorithme de tri à bulles
-void col_trier(Collection self)
+// @brief Ajoute à la fin de self les voitures lues au format CSV, retourne leur nombre
+//        Le fichier est lu par gros blocs et les champs sont découpés sur place, sans allocation
+//        par champ ; les voitures créées sont insérées directement, sans copie.
+int col_importerCSV(Collection self, FILE *fd)
 {
-    myassert(self != NULL, "col_trier - Collection is null");
+    if (self == NULL || fd == NULL)
+    {
+        fprintf(stderr, "Error:Collection - col_importerCSV - collection or file is null");
+        exit(EXIT_FAILURE);
+    }
 
-    if (!(self->estTrie))
+    col_detacher(self);
+
+    size_t capacite = TAILLE_TAMPON_CSV;
+    // un octet de plus pour terminer le dernier champ du fichier
+    char *tampon = malloc(capacite + 1);
+    if (tampon == NULL)
+    {
+        fprintf(stderr, "Error:Collection - col_importerCSV - mem alloc failed");
+        exit(EXIT_FAILURE);
+    }
+    char **champs = NULL;
+    int capaciteChamps = 0;
+
+    size_t taille = 0;
+    bool estFinFichier = false;
+    int numeroLigne = 1; // ligne du début de l'enregistrement courant
+    bool estPremierEnregistrement = true;
+    int nbVoitures = 0;
+    while (!estFinFichier)
     {
-        for (int i = self->nombreVoitures - 1; i >= 0; i--)
+        size_t aLire = capacite - taille;
+        size_t lu = fread(tampon + taille, 1, aLire, fd);
+        taille += lu;
+        estFinFichier = (lu < aLire);
+
+        size_t debut = 0;
+        while (debut < taille)
         {
-            Element *element = self->premier;
-            for (int j = 0; j < i; j++)
+            // Fin de l'enregistrement : le prochain saut de ligne hors guillemets
+            size_t fin = debut;
+            bool estEntreGuillemets = false;
+            int nbSautsLigne = 0;
+            while (fin < taille && (estEntreGuillemets || tampon[fin] != '\n'))
             {
-                if (element == NULL)
-                    break;
-                else if (element->suivant == NULL)
-                    break;
+                if (tampon[fin] == '"')
+                    estEntreGuillemets = !estEntreGuillemets;
+                else if (tampon[fin] == '\n')
+                    nbSautsLigne++;
+                fin++;
+            }
+            if (fin == taille && !estFinFichier)
+                break; // enregistrement incomplet, on attend la suite du fichier
 
-                if (voi_getAnnee(element->suivant->voiture) < voi_getAnnee(element->voiture))
-                    voi_swap(element->voiture, element->suivant->voiture);
+            size_t suivant = fin + 1;
+            if (fin > debut && tampon[fin - 1] == '\r')
+                fin--;
 
-                element = element->suivant;
+            // Seule la première ligne non vide peut être l'en-tête, et seulement si elle lui est identique
+            bool estEnTete = false;
+            if (fin > debut && estPremierEnregistrement)
+            {
+                estEnTete = (fin - debut == strlen(EN_TETE_CSV)
+                             && memcmp(tampon + debut, EN_TETE_CSV, fin - debut) == 0);
+                estPremierEnregistrement = false;
+            }
+
+            if (fin > debut && !estEnTete)
+            {
+                int nbChamps = csv_decouper(tampon + debut, tampon + fin, &champs, &capaciteChamps);
+                if (nbChamps < 3)
+                {
+                    fprintf(stderr, "Error:Collection - col_importerCSV - line %d : missing fields", numeroLigne);
+                    exit(EXIT_FAILURE);
+                }
+                // Les marques et immatriculations sont relues dans des tableaux de COL_MAX_LEN + 1
+                for (int i = 0; i < nbChamps; i++)
+                {
+                    if (strlen(champs[i]) > COL_MAX_LEN)
+                    {
+                        fprintf(stderr, "Error:Collection - col_importerCSV - line %d : field too long", numeroLigne);
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                Voiture voiture = voi_creer(champs[0], csv_lireEntier(champs[1], numeroLigne),
+                                            csv_lireEntier(champs[2], numeroLigne),
+                                            nbChamps - 3, (const char **)(champs + 3));
+                col_ajouterElementFin(self, element_creer(partage_creer(voiture)));
+                nbVoitures++;
+            }
+            numeroLigne += 1 + nbSautsLigne;
+            debut = suivant;
+        }
+
+        // On garde le début d'enregistrement incomplet pour la lecture suivante
+        if (debut < taille)
+        {
+            taille -= debut;
+            memmove(tampon, tampon + debut, taille);
+        }
+        else
+        {
+            taille = 0;
+        }
+        if (taille == capacite)
+        {
+            capacite *= 2;
+            tampon = realloc(tampon, capacite + 1);
+            if (tampon == NULL)
+            {
+                fprintf(stderr, "Error:Collection - col_importerCSV - mem alloc failed");
+                exit(EXIT_FAILURE);
             }
         }
-        self->estTrie = true;
     }
+
+    free(champs);
+    free(tampon);
+    return nbVoitures;
 }
 
+
 /*----------*
- * méthode secondaire d'affichage
+ * sauvegarde asynchrone
  *----------*/
 
-// @brief Affiche les éléments de la collection et de toutes les voitures qu'elle contient
-void col_afficher(const_Collection self)
+// taille des écritures envoyées au système
+#define TAILLE_ECRITURE (4 * 1024 * 1024)
+
+struct SauvegardeP
 {
-    printf("Collection :\n");
-    printf("\tEst trié : %s\n", self->estTrie ? "Vrai" : "Faux");
-    printf("\tNombre de voitures : %d\n", self->nombreVoitures);
+    Collection instantane; // copie (copy-on-write) prise au lancement
+    int descripteur;
+    pthread_t thread;
+    pthread_mutex_t verrou;
+    bool estTerminee;
+};
 
-    Element *elementSuivant = self->premier;
-    while (elementSuivant != NULL)
+// @brief Sérialise l'instantané en mémoire puis l'écrit par gros blocs avec pwrite
+static void *sauvegarde_executer(void *arg)
+{
+    Sauvegarde sauvegarde = arg;
+    char *tampon = NULL;
+    size_t taille = 0;
+
+    FILE *flux = open_memstream(&tampon, &taille);
+    if (flux == NULL)
     {
-        voi_afficher(elementSuivant->voiture);
-        elementSuivant = elementSuivant->suivant;
+        fprintf(stderr, "Error:Collection - sauvegarde_executer - open_memstream failed");
+        exit(EXIT_FAILURE);
     }
-}
+    col_ecrireFichier(sauvegarde->instantane, flux);
+    fclose(flux);
 
-/*----------*
- * entrées-sorties fichiers
- * note : le paramètre est un fichier déjà ouvert
- *----------*/
+    size_t ecrit = 0;
+    while (ecrit < taille)
+    {
+        size_t aEcrire = taille - ecrit < TAILLE_ECRITURE ? taille - ecrit : TAILLE_ECRITURE;
+        ssize_t n = pwrite(sauvegarde->descripteur, tampon + ecrit, aEcrire, ecrit);
+        if (n < 0)
+        {
+            fprintf(stderr, "Error:Collection - sauvegarde_executer - pwrite failed");
+            exit(EXIT_FAILURE);
+        }
+        ecrit += n;
+    }
+    free(tampon);
 
-// @brief Ecrit les données d'une collection dans un fichier
-void col_ecrireFichier(const_Collection self, FILE *fd)
+    pthread_mutex_lock(&(sauvegarde->verrou));
+    sauvegarde->estTerminee = true;
+    pthread_mutex_unlock(&(sauvegarde->verrou));
+    return NULL;
+}
+
+// @brief Lance l'écriture de self dans fd (même format que col_ecrireFichier) sur un thread
+//        Le lancement ne fait qu'une copie O(1) de self, qui peut ensuite être modifiée librement ;
+//        mais tant que l'instantané n'est pas libéré (col_attendreSauvegarde), la première modification de self
+//        détache sa liste (col_detacher), en O(n) dans le thread de l'appelant.
+//        fd ne doit pas être utilisé avant col_attendreSauvegarde.
+Sauvegarde col_ecrireFichierAsync(const_Collection self, FILE *fd)
 {
     if (self == NULL || fd == NULL)
     {
-        fprintf(stderr, "Error:Collection - col_ecrireFichier - collection or file is null");
+        fprintf(stderr, "Error:Collection - col_ecrireFichierAsync - collection or file is null");
         exit(EXIT_FAILURE);
     }
 
-    fseek(fd, 0, SEEK_SET);
-    fwrite(&(self->estTrie), sizeof(bool), 1, fd);
-    fwrite(&(self->nombreVoitures), sizeof(int), 1, fd);
-
-    Element *element = self->premier;
-
-    while (element != NULL)
+    Sauvegarde result = malloc(sizeof(struct SauvegardeP));
+    // Dans le cas ou la mémoire n'est pas allouée correctement, le programme échoue
+    if (result == NULL)
     {
-        voi_ecrireFichier(element->voiture, fd);
-        element = element->suivant;
+        fprintf(stderr, "Error:Collection - col_ecrireFichierAsync - mem alloc failed");
+        exit(EXIT_FAILURE);
     }
-}
 
-// @brief Remplie la collection self avec les données stockés dans le fichier fd
-void col_lireFichier(Collection self, FILE *fd)
-{
-    if (self == NULL || fd == NULL)
+    // Les données encore dans le tampon de fd ne doivent pas être écrites après les nôtres
+    fflush(fd);
+    result->instantane = col_creerCopie(self);
+    result->descripteur = fileno(fd);
+    result->estTerminee = false;
+    pthread_mutex_init(&(result->verrou), NULL);
+    if (pthread_create(&(result->thread), NULL, sauvegarde_executer, result) != 0)
     {
-        fprintf(stderr, "Error:Collection - col_lireFichier - collection or file is null");
+        fprintf(stderr, "Error:Collection - col_ecrireFichierAsync - pthread_create failed");
         exit(EXIT_FAILURE);
     }
+    return result;
+}
 
-    col_vider(self); // On vide la collection pour pouvoir l'écraser
-    fseek(fd, 0, SEEK_SET);
+// @brief Indique, sans bloquer, si l'écriture est terminée
+bool col_sauvegardeTerminee(Sauvegarde sauvegarde)
+{
+    myassert(sauvegarde != NULL, "col_sauvegardeTerminee - Sauvegarde is null");
 
-    fread(&(self->estTrie), sizeof(bool), 1, fd);
-    fread(&(self->nombreVoitures), sizeof(int), 1, fd);
+    pthread_mutex_lock(&(sauvegarde->verrou));
+    bool result = sauvegarde->estTerminee;
+    pthread_mutex_unlock(&(sauvegarde->verrou));
+    return result;
+}
 
-    Element *element = (Element *)malloc(sizeof(struct Element));
-    if (element == NULL)
+// @brief Attend la fin de l'écriture et libère la sauvegarde
+//        note : à appeler depuis le thread qui manipule la collection sauvegardée,
+//        la libération de l'instantané modifiant les compteurs de références partagés
+void col_attendreSauvegarde(Sauvegarde *psauvegarde)
+{
+    myassert(psauvegarde != NULL && *psauvegarde != NULL, "col_attendreSauvegarde - Sauvegarde is null");
+
+    pthread_join((*psauvegarde)->thread, NULL);
+    pthread_mutex_destroy(&((*psauvegarde)->verrou));
+    col_detruire(&((*psauvegarde)->instantane));
+    free(*psauvegarde);
+    *psauvegarde = NULL;
+}
+
+
+/*=================================================================*
+ * Collection persistante
+ *=================================================================*/
+
+/*----------*
+ * définition de la structure
+ *----------*/
+
+// Noeud d'un arbre AVL immuable ordonné par année.
+// Un noeud peut appartenir à plusieurs versions, il n'est donc jamais modifié
+// après sa création : chaque mise à jour recopie uniquement le chemin depuis la racine.
+typedef struct Noeud
+{
+    VoiturePartagee *partage;
+    struct Noeud *gauche;
+    struct Noeud *droite;
+    int hauteur;
+    int taille; // nombre de voitures du sous-arbre, pour l'accès par position
+    int nbReferences;
+} Noeud;
+
+struct ColPersistanteP
+{
+    Noeud *racine;
+};
+
+/*----------*
+ * gestion des noeuds
+ *----------*/
+
+static int noeud_hauteur(const Noeud *noeud)
+{
+    return noeud == NULL ? 0 : noeud->hauteur;
+}
+
+static int noeud_taille(const Noeud *noeud)
+{
+    return noeud == NULL ? 0 : noeud->taille;
+}
+
+// @brief Ajoute une référence sur un noeud (NULL accepté)
+static Noeud *noeud_retenir(Noeud *noeud)
+{
+    if (noeud != NULL)
+        noeud->nbReferences++;
+    return noeud;
+}
+
+// @brief Retire une référence, le sous-arbre est libéré à la dernière
+static void noeud_liberer(Noeud *noeud)
+{
+    if (noeud == NULL)
+        return;
+    noeud->nbReferences--;
+    if (noeud->nbReferences == 0)
+    {
+        noeud_liberer(noeud->gauche);
+        noeud_liberer(noeud->droite);
+        partage_liberer(noeud->partage);
+        free(noeud);
+    }
+}
+
+// @brief Créer un noeud, en prenant possession des références passées en paramètre
+static Noeud *noeud_creer(VoiturePartagee *partage, Noeud *gauche, Noeud *droite)
+{
+    Noeud *result = malloc(sizeof(Noeud));
+    // Dans le cas ou la mémoire n'est pas allouée correctement, le programme échoue
+    if (result == NULL)
     {
-        fprintf(stderr, "Error:Collection - col_lireFichier - element is null");
+        fprintf(stderr, "Error:Collection - noeud_creer - mem alloc failed");
         exit(EXIT_FAILURE);
     }
+    result->partage = partage;
+    result->gauche = gauche;
+    result->droite = droite;
+    int hauteurGauche = noeud_hauteur(gauche);
+    int hauteurDroite = noeud_hauteur(droite);
+    result->hauteur = 1 + (hauteurGauche > hauteurDroite ? hauteurGauche : hauteurDroite);
+    result->taille = 1 + noeud_taille(gauche) + noeud_taille(droite);
+    result->nbReferences = 1;
+    return result;
+}
 
-    if (self->nombreVoitures == 1)
+// @brief Créer un noeud équilibré à partir de deux sous-arbres dont les hauteurs
+//        diffèrent au plus de 2 (prend possession des références)
+static Noeud *noeud_equilibrer(VoiturePartagee *partage, Noeud *gauche, Noeud *droite)
+{
+    if (noeud_hauteur(gauche) > noeud_hauteur(droite) + 1)
     {
-        // Si le fichier ne comporte qu'une voiture, la liste ne contient qu'une seule voiture
-        if (element == NULL)
+        Noeud *result;
+        if (noeud_hauteur(gauche->gauche) >= noeud_hauteur(gauche->droite))
         {
-            fprintf(stderr, "Error:Collection - col_lireFichier - element is null");
-            exit(EXIT_FAILURE);
+            // Rotation simple à droite
+            result = noeud_creer(partage_retenir(gauche->partage),
+                                 noeud_retenir(gauche->gauche),
+                                 noeud_creer(partage, noeud_retenir(gauche->droite), droite));
+        }
+        else
+        {
+            // Rotation double gauche-droite
+            Noeud *pivot = gauche->droite;
+            result = noeud_creer(partage_retenir(pivot->partage),
+                                 noeud_creer(partage_retenir(gauche->partage),
+                                             noeud_retenir(gauche->gauche),
+                                             noeud_retenir(pivot->gauche)),
+                                 noeud_creer(partage, noeud_retenir(pivot->droite), droite));
+        }
+        noeud_liberer(gauche);
+        return result;
+    }
+    else if (noeud_hauteur(droite) > noeud_hauteur(gauche) + 1)
+    {
+        Noeud *result;
+        if (noeud_hauteur(droite->droite) >= noeud_hauteur(droite->gauche))
+        {
+            // Rotation simple à gauche
+            result = noeud_creer(partage_retenir(droite->partage),
+                                 noeud_creer(partage, gauche, noeud_retenir(droite->gauche)),
+                                 noeud_retenir(droite->droite));
         }
+        else
+        {
+            // Rotation double droite-gauche
+            Noeud *pivot = droite->gauche;
+            result = noeud_creer(partage_retenir(pivot->partage),
+                                 noeud_creer(partage, gauche, noeud_retenir(pivot->gauche)),
+                                 noeud_creer(partage_retenir(droite->partage),
+                                             noeud_retenir(pivot->droite),
+                                             noeud_retenir(droite->droite)));
+        }
+        noeud_liberer(droite);
+        return result;
+    }
+    return noeud_creer(partage, gauche, droite);
+}
 
-        element->voiture = voi_creerFromFichier(fd);
-        element->precedent = NULL;
-        element->suivant = NULL;
+// @brief Retourne un nouvel arbre contenant la voiture en plus de ceux de noeud
+//        Les voitures de même année sont rangées dans leur ordre d'arrivée
+static Noeud *noeud_inserer(Noeud *noeud, VoiturePartagee *partage)
+{
+    if (noeud == NULL)
+        return noeud_creer(partage, NULL, NULL);
 
-        self->premier = element;
-        self->dernier = element;
+    if (voi_getAnnee(partage->voiture) < voi_getAnnee(noeud->partage->voiture))
+        return noeud_equilibrer(partage_retenir(noeud->partage),
+                                noeud_inserer(noeud->gauche, partage),
+                                noeud_retenir(noeud->droite));
+    else
+        return noeud_equilibrer(partage_retenir(noeud->partage),
+                                noeud_retenir(noeud->gauche),
+                                noeud_inserer(noeud->droite, partage));
+}
+
+// @brief Retourne un nouvel arbre privé de la voiture de rang pos
+static Noeud *noeud_supprimer(Noeud *noeud, int pos)
+{
+    int tailleGauche = noeud_taille(noeud->gauche);
+
+    if (pos < tailleGauche)
+        return noeud_equilibrer(partage_retenir(noeud->partage),
+                                noeud_supprimer(noeud->gauche, pos),
+                                noeud_retenir(noeud->droite));
+    else if (pos > tailleGauche)
+        return noeud_equilibrer(partage_retenir(noeud->partage),
+                                noeud_retenir(noeud->gauche),
+                                noeud_supprimer(noeud->droite, pos - tailleGauche - 1));
+
+    if (noeud->gauche == NULL)
+        return noeud_retenir(noeud->droite);
+    if (noeud->droite == NULL)
+        return noeud_retenir(noeud->gauche);
+
+    // On remplace le noeud par son successeur (le minimum du sous-arbre droit)
+    Noeud *successeur = noeud->droite;
+    while (successeur->gauche != NULL)
+    {
+        successeur = successeur->gauche;
     }
+    return noeud_equilibrer(partage_retenir(successeur->partage),
+                            noeud_retenir(noeud->gauche),
+                            noeud_supprimer(noeud->droite, 0));
+}
+
+// @brief Construit un arbre parfaitement équilibré avec les taille voitures de la liste triée
+//        qui commence à *pelement, en O(taille) ; *pelement avance jusqu'à l'élément suivant
+static Noeud *noeud_construire(Element **pelement, int taille)
+{
+    if (taille == 0)
+        return NULL;
+
+    Noeud *gauche = noeud_construire(pelement, taille / 2);
+    VoiturePartagee *partage = partage_retenir((*pelement)->partage);
+    *pelement = (*pelement)->suivant;
+    Noeud *droite = noeud_construire(pelement, taille - taille / 2 - 1);
+    return noeud_creer(partage, gauche, droite);
+}
+
+// @brief Ajoute à la fin de collection les voitures du sous-arbre, dans l'ordre
+static void noeud_versCollection(const Noeud *noeud, Collection collection)
+{
+    if (noeud == NULL)
+        return;
+
+    noeud_versCollection(noeud->gauche, collection);
+
+    Element *element = element_creer(partage_retenir(noeud->partage));
+    stats_ajouter(&(collection->chaine->stats), element->partage->voiture);
+    element->precedent = collection->dernier;
+    if (collection->dernier == NULL)
+        collection->premier = element;
     else
+        collection->dernier->suivant = element;
+    collection->dernier = element;
+    collection->nombreVoitures++;
+    collection->tailleTriee++;
+
+    noeud_versCollection(noeud->droite, collection);
+}
+
+// @brief Créer le descripteur d'une version (prend possession de la racine)
+static ColPersistante colp_creerVersion(Noeud *racine)
+{
+    ColPersistante result = malloc(sizeof(struct ColPersistanteP));
+    // Dans le cas ou la mémoire n'est pas allouée correctement, le programme échoue
+    if (result == NULL)
     {
-        // Si il y a plus d'une voiture stocké sur le disque, on créer la liste voiture par voiture
-        for (int i = 0; i < self->nombreVoitures - 1; i++)
-        {
-            Element *elementSuivant = (Element *)malloc(sizeof(struct Element));
+        fprintf(stderr, "Error:Collection - colp_creerVersion - mem alloc failed");
+        exit(EXIT_FAILURE);
+    }
+    result->racine = racine;
+    return result;
+}
 
-            if (elementSuivant == NULL)
-            {
-                fprintf(stderr, "Error:Collection - col_lireFichier - elementSuivant is null");
-                exit(EXIT_FAILURE);
-            }
+/*----------*
+ * initialisation de la structure
+ *----------*/
 
-            element->voiture = voi_creerFromFichier(fd);
-            if (i == 0)
-            {
+// @brief Créer une version vide
+ColPersistante colp_creer()
+{
+    return colp_creerVersion(NULL);
+}
 
-                element->precedent = NULL;
+// @brief Créer une version contenant les voitures de source
+ColPersistante colp_creerDepuisCollection(const_Collection source)
+{
+    myassert(source != NULL, "colp_creerDepuisCollection - Source is null");
 
-                self->premier = element;
-            }
-            else if (i == self->nombreVoitures - 2)
-            {
-                elementSuivant->voiture = voi_creerFromFichier(fd);
-                elementSuivant->suivant = NULL;
+    // Le tri stable d'une copie range les voitures de même année dans leur ordre
+    // d'arrivée, comme noeud_inserer ; si source est déjà triée, la copie ne coûte rien
+    Collection triee = col_creerCopie(source);
+    col_trier(triee);
 
-                self->dernier = elementSuivant;
-            }
+    Element *element = triee->premier;
+    Noeud *racine = noeud_construire(&element, triee->nombreVoitures);
+    col_detruire(&triee);
+    return colp_creerVersion(racine);
+}
 
-            elementSuivant->precedent = element;
-            element->suivant = elementSuivant;
-            element = elementSuivant;
+// @brief Détruit la version, les noeuds partagés avec d'autres versions sont conservés
+void colp_detruire(ColPersistante *pself)
+{
+    noeud_liberer((*pself)->racine);
+    free(*pself);
+    *pself = NULL;
+}
+
+/*----------*
+ * accesseurs
+ *----------*/
+
+// @brief Retourne le nombre de voitures de la version
+int colp_getNbVoitures(const_ColPersistante self)
+{
+    myassert(self != NULL, "colp_getNbVoitures - input invalid");
+    return noeud_taille(self->racine);
+}
+
+// @brief Retourne une copie de la voiture de rang [pos]
+Voiture colp_getVoiture(const_ColPersistante self, int pos)
+{
+    myassert(self != NULL, "colp_getVoiture - ColPersistante is null");
+    myassert((pos >= 0) && (pos < noeud_taille(self->racine)), "colp_getVoiture - Position not valid");
+
+    const Noeud *noeud = self->racine;
+    while (pos != noeud_taille(noeud->gauche))
+    {
+        if (pos < noeud_taille(noeud->gauche))
+        {
+            noeud = noeud->gauche;
         }
+        else
+        {
+            pos -= noeud_taille(noeud->gauche) + 1;
+            noeud = noeud->droite;
+        }
+    }
+    return voi_creerCopie(noeud->partage->voiture);
+}
+
+// @brief Retourne une nouvelle version contenant en plus la voiture
+ColPersistante colp_addVoiture(const_ColPersistante self, const_Voiture voiture)
+{
+    myassert(self != NULL, "colp_addVoiture - ColPersistante is null");
+    myassert(voiture != NULL, "colp_addVoiture - Car is null");
+
+    return colp_creerVersion(noeud_inserer(self->racine, partage_creer(voi_creerCopie(voiture))));
+}
+
+// @brief Retourne une nouvelle version privée de la voiture de rang [pos]
+ColPersistante colp_supprVoiture(const_ColPersistante self, int pos)
+{
+    myassert(self != NULL, "colp_supprVoiture - ColPersistante is null");
+    myassert((pos >= 0) && (pos < noeud_taille(self->racine)), "colp_supprVoiture - Position not valid");
+
+    return colp_creerVersion(noeud_supprimer(self->racine, pos));
+}
+
+// @brief Retourne une collection triée partageant les voitures de la version
+Collection colp_versCollection(const_ColPersistante self)
+{
+    myassert(self != NULL, "colp_versCollection - ColPersistante is null");
+
+    Collection result = col_creer();
+    noeud_versCollection(self->racine, result);
+    return result;
+}
+
+/*----------*
+ * méthode secondaire d'affichage
+ *----------*/
+
+// @brief Affiche les voitures de la version dans l'ordre trié
+void colp_afficher(const_ColPersistante self)
+{
+    Collection collection = colp_versCollection(self);
+    printf("Collection persistante :\n");
+    printf("\tNombre de voitures : %d\n", collection->nombreVoitures);
+
+    Element *elementSuivant = collection->premier;
+    while (elementSuivant != NULL)
+    {
+        voi_afficher(elementSuivant->partage->voiture);
+        elementSuivant = elementSuivant->suivant;
     }
-}
\ No newline at end of file
+    col_detruire(&collection);
+}
@@ -6,9 +6,13 @@
 #define COLLECTION_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "Voiture.h"
 
+// Les marques et immatriculations des voitures d'une collection ne doivent pas dépasser
+// 1000 caractères (COL_MAX_LEN) : le module les relit dans des tableaux de cette taille
+// (statistiques, formats de fichier, filtres), le module Voiture ne donnant pas leur longueur
 struct CollectionP;
 typedef struct CollectionP * Collection;
 typedef const struct CollectionP * const_Collection;
@@ -32,15 +36,87 @@ int col_getNbVoitures(const_Collection self);
 // on récupère une copie de la voiture
 Voiture col_getVoiture(const_Collection self, int pos);
 
+// la voiture est copiée au préalable si elle est partagée avec une autre collection
+void col_setKilometrage(Collection self, int pos, int kilometrage);
+
 void col_addVoitureSansTri(Collection self, const_Voiture voiture);
 void col_addVoitureAvecTri(Collection self, const_Voiture voiture);
 
 void col_supprVoitureSansTri(Collection self, int pos);
 void col_supprVoitureAvecTri(Collection self, int pos);
 
+// suppressions en un seul parcours, retournent le nombre de voitures supprimées
+typedef bool (*ColPredicat)(const_Voiture voiture, void *ctx);
+int col_supprimerSi(Collection self, ColPredicat predicat, void *ctx);
+// les positions peuvent être dans n'importe quel ordre, les doublons sont ignorés
+int col_supprimerPositions(Collection self, const int positions[], int n);
+
 void col_trier(Collection self);
 
 
+/*----------*
+ * combinaison de collections
+ * les voitures ne sont jamais copiées : elles sont déplacées ou partagées
+ *----------*/
+// fusion triée de source dans self (triées au préalable si besoin)
+// si deplacer est vrai, les éléments de source sont déplacés et source est vidée
+void col_fusionner(Collection self, Collection source, bool deplacer);
+// déplace source à la fin de self, source est vidée
+void col_concatener(Collection self, Collection source);
+// voitures de self selon que leur immatriculation actuelle (la dernière) apparaît dans autre ou non
+Collection col_difference(const_Collection self, const_Collection autre);
+Collection col_intersection(const_Collection self, const_Collection autre);
+
+
+/*----------*
+ * statistiques propres à la collection
+ * maintenues à chaque modification, la lecture ne parcourt pas la liste
+ * note : les années et les moyennes n'ont pas de sens sur une collection vide
+ *----------*/
+int col_stat_getAnneeMin(const_Collection self);
+int col_stat_getAnneeMax(const_Collection self);
+double col_stat_getAnneeMoyenne(const_Collection self);
+long long col_stat_getKilometrageTotal(const_Collection self);
+double col_stat_getKilometrageMoyen(const_Collection self);
+int col_stat_getNbVoituresAnnee(const_Collection self, int annee);
+int col_stat_getNbVoituresMarque(const_Collection self, const char *marque);
+
+
+/*----------*
+ * statistiques d'ordre (médiane, percentiles, k plus grands)
+ *----------*/
+typedef enum
+{
+    COL_CLE_ANNEE,
+    COL_CLE_KILOMETRAGE
+} ColCle;
+
+// p entre 0 et 100 (50 pour la médiane), méthode du rang le plus proche
+int col_percentile(const_Collection self, ColCle cle, double p);
+// copie dans out les k voitures de plus grande clé, par ordre décroissant
+// retourne le nombre de voitures copiées (moins de k si la collection est plus petite)
+int col_topK(const_Collection self, ColCle cle, int k, Voiture out[]);
+
+
+/*----------*
+ * empreinte mémoire
+ * les voitures partagées avec d'autres collections sont comptées dans chacune
+ *----------*/
+typedef struct
+{
+    size_t elements;     // maillons de la liste
+    size_t voitures;     // structures des voitures
+    size_t chaines;      // marques et immatriculations (estimation via le module Voiture)
+    size_t statistiques; // descripteur de la collection et statistiques
+    size_t perdu;        // réservé mais inutilisé (arrondis de malloc, cases libérées)
+    size_t total;
+} ColMemoire;
+
+ColMemoire col_getMemoryUsage(const_Collection self);
+// range éléments et voitures dans un stockage contigu, dans l'ordre de la liste,
+// et rend la mémoire libérée au système
+void col_compacter(Collection self);
+
 /*----------*
  * méthode secondaire d'affichage
  *----------*/
@@ -54,4 +130,70 @@ void col_afficher(const_Collection self);
 void col_ecrireFichier(const_Collection self, FILE *fd);
 void col_lireFichier(Collection self, FILE *fd);
 
+// format compressé (dictionnaire de marques, varints), relu par col_lireFichier
+void col_ecrireFichierCompresse(const_Collection self, FILE *fd);
+
+// texte CSV (un en-tête puis une voiture par ligne, l'en-tête est facultatif à l'import),
+// lu et écrit à la position courante
+// l'import ajoute les voitures à la fin de la collection et retourne leur nombre,
+// il échoue sur un champ de plus de 1000 caractères
+void col_exporterCSV(const_Collection self, FILE *fd);
+int col_importerCSV(Collection self, FILE *fd);
+
+// format découpé en blocs indépendants, encodés et décodés par nbThreads threads
+// limite : à la lecture, les créations de voitures (voi_creer, qui alloue et tient des
+// statistiques globales non protégées) restent sérialisées par un verrou global ; seuls
+// la lecture et le décodage des blocs sont parallèles, le gain n'est pas proportionnel
+// au nombre de cœurs
+void col_ecrireFichierParallele(const_Collection self, FILE *fd, int nbThreads);
+void col_lireFichierParallele(Collection self, FILE *fd, int nbThreads);
+
+
+/*----------*
+ * sauvegarde asynchrone
+ * le lancement ne coûte que la copie (copy-on-write) de la collection,
+ * l'écriture au format de col_ecrireFichier est faite par un thread
+ * attention : tant que col_attendreSauvegarde n'a pas été appelée, la première
+ * modification de la collection source recopie ses n éléments dans le thread
+ * appelant (O(n)), les suivantes retrouvent leur coût habituel
+ *----------*/
+struct SauvegardeP;
+typedef struct SauvegardeP * Sauvegarde;
+
+Sauvegarde col_ecrireFichierAsync(const_Collection self, FILE *fd);
+bool col_sauvegardeTerminee(Sauvegarde sauvegarde);
+// attend la fin de l'écriture et libère la sauvegarde
+void col_attendreSauvegarde(Sauvegarde *psauvegarde);
+
+
+/*=================================================================*
+ * Collection persistante
+ * Chaque version est immuable et triée par année : un ajout ou une
+ * suppression produit une nouvelle version en O(log n) qui partage
+ * la quasi-totalité de sa structure avec la précédente.
+ * Conserver une version ne coûte rien de plus que son descripteur.
+ *=================================================================*/
+struct ColPersistanteP;
+typedef struct ColPersistanteP * ColPersistante;
+typedef const struct ColPersistanteP * const_ColPersistante;
+
+ColPersistante colp_creer();
+// les voitures sont partagées avec la collection source
+ColPersistante colp_creerDepuisCollection(const_Collection source);
+
+void colp_detruire(ColPersistante *pself);
+
+int colp_getNbVoitures(const_ColPersistante self);
+// on récupère une copie de la voiture, pos est le rang dans l'ordre trié
+Voiture colp_getVoiture(const_ColPersistante self, int pos);
+
+// self n'est pas modifiée, on récupère une nouvelle version
+ColPersistante colp_addVoiture(const_ColPersistante self, const_Voiture voiture);
+ColPersistante colp_supprVoiture(const_ColPersistante self, int pos);
+
+// collection triée partageant les voitures de la version
+Collection colp_versCollection(const_ColPersistante self);
+
+void colp_afficher(const_ColPersistante self);
+
 #endif
@@ -0,0 +1,86 @@
+/********************************************************************
+ * Point d'entrée libFuzzer : lecture d'un fichier de collection
+ * (format brut ou compressé, via col_lireFichier), puis import de
+ * la même entrée au format CSV (col_importerCSV)
+ *
+ * construction : make fuzz_lecture (clang)
+ * exécution    : ./fuzz_lecture -detect_leaks=0 [répertoire du corpus]
+ *
+ * Le module rejette les entrées invalides par exit(EXIT_FAILURE), que
+ * libFuzzer considère comme un plantage. exit est donc enveloppé à
+ * l'édition de liens (-Wl,--wrap=exit) : pendant une lecture, il ramène
+ * à l'entrée suivante. Ce que le lecteur avait alloué localement est
+ * alors perdu, d'où -detect_leaks=0.
+ ********************************************************************/
+
+// fmemopen
+#define _POSIX_C_SOURCE 200809L
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Collection.h"
+
+static jmp_buf retour;
+static bool estEnLecture = false;
+
+void __real_exit(int status);
+
+// @brief Remplace exit : une erreur de lecture termine l'entrée courante, pas le fuzzer
+void __wrap_exit(int status)
+{
+    if (estEnLecture)
+    {
+        estEnLecture = false;
+        longjmp(retour, 1);
+    }
+    __real_exit(status);
+}
+
+// @brief Vérifie que la collection lue reste utilisable
+static void verifier(const_Collection c)
+{
+    Collection copie = col_creerCopie(c);
+    col_trier(copie);
+    col_getMemoryUsage(copie);
+    col_detruire(&copie);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    // fmemopen refuse un tampon vide
+    if (size == 0)
+        return 0;
+
+    FILE *fd = fmemopen((void *)data, size, "r");
+    if (fd == NULL)
+        return 0;
+
+    // La collection reste cohérente quand la lecture est interrompue :
+    // les voitures y sont ajoutées une à une, elle peut donc être détruite
+    Collection c = col_creer();
+    if (setjmp(retour) == 0)
+    {
+        estEnLecture = true;
+        col_lireFichier(c, fd);
+        estEnLecture = false;
+        verifier(c);
+    }
+    col_detruire(&c);
+
+    rewind(fd);
+    c = col_creer();
+    if (setjmp(retour) == 0)
+    {
+        estEnLecture = true;
+        col_importerCSV(c, fd);
+        estEnLecture = false;
+        verifier(c);
+    }
+    col_detruire(&c);
+    fclose(fd);
+    return 0;
+}
@@ -1,7 +1,12 @@
+// clock_gettime
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <limits.h>
+#include <time.h>
 
 #include "myassert.h"
 
@@ -10,7 +15,7 @@
 
 static void usage(const char *exe)
 {
-    fprintf(stdout, "usage %s [full]\n", exe);
+    fprintf(stdout, "usage %s [full | stress | lire <fichier>]\n", exe);
     exit(EXIT_FAILURE);
 }
 
@@ -133,7 +138,7 @@ void testCollections(bool full)
     voi_detruire(&v);
 
     v = voi_creer("Cosmosine", 1999, 12571, 1, plaques+4);
-    //col_addVoitureAvecTri(c1, v);  // boom !
+    //col_addVoitureAvecTri(c1, v);  // trierait c1 avant l'ajout
     col_addVoitureSansTri(c1, v);
     voi_detruire(&v);
 
@@ -173,6 +178,14 @@ void testCollections(bool full)
     printf("      8 voitures : Colectine, Pixile, Orwelline, Cosmosine, Loopile, Orchidile, Trombine, Ondine\n");
     col_afficher(c1);
 
+    printf("\nStatistiques de c1 =====================================\n");
+    printf("  années         : %d à %d (1902 à 2018 normalement)\n",
+           col_stat_getAnneeMin(c1), col_stat_getAnneeMax(c1));
+    printf("  année moyenne  : %.2f (1987.25 normalement)\n", col_stat_getAnneeMoyenne(c1));
+    printf("  kilométrage    : %lld (830598 normalement)\n", col_stat_getKilometrageTotal(c1));
+    printf("  voitures de 2006 : %d (1 normalement)\n", col_stat_getNbVoituresAnnee(c1, 2006));
+    printf("  Ondine         : %d (1 normalement)\n", col_stat_getNbVoituresMarque(c1, "Ondine"));
+
     if (full)
     {
         FILE *fd;
@@ -248,13 +261,803 @@ void testStatistiques()
 }
 
 
+/*=================================================================*
+ * Comparaison des formats de fichier (brut et compressé)
+ *=================================================================*/
+#define NB_VOITURES_FORMATS 100000
+
+static bool voitureImpaire(const_Voiture v, void *ctx)
+{
+    // ctx compte les voitures parcourues
+    (void)v;
+    return (*(int *)ctx)++ % 2 == 1;
+}
+
+static void afficherMemoire(const char *titre, ColMemoire memoire)
+{
+    printf("  %s : %zu octets\n", titre, memoire.total);
+    printf("    éléments %zu, voitures %zu, chaînes %zu, statistiques %zu, perdu %zu\n",
+           memoire.elements, memoire.voitures, memoire.chaines,
+           memoire.statistiques, memoire.perdu);
+}
+
+static void ecrireFormat(const_Collection c, const char *nomFichier, bool compresse)
+{
+    FILE *fd = fopen(nomFichier, "w");
+    myassert(fd != NULL, "probleme ouverture fichier écriture");
+    if (compresse)
+        col_ecrireFichierCompresse(c, fd);
+    else
+        col_ecrireFichier(c, fd);
+    fclose(fd);
+}
+
+// retourne la taille du fichier, et la durée de lecture dans *duree
+static long lireFormat(const char *nomFichier, double *duree)
+{
+    FILE *fd = fopen(nomFichier, "r");
+    myassert(fd != NULL, "probleme ouverture fichier lecture");
+    Collection c = col_creer();
+    clock_t debut = clock();
+    col_lireFichier(c, fd);
+    *duree = (double)(clock() - debut) / CLOCKS_PER_SEC;
+    fseek(fd, 0, SEEK_END);
+    long taille = ftell(fd);
+    fclose(fd);
+    col_detruire(&c);
+    return taille;
+}
+
+// durée réelle écoulée, clock() cumulant le temps de tous les threads
+static double secondes()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// retourne la durée de lecture du format par blocs avec nbThreads threads
+static double lireFormatParallele(const char *nomFichier, int nbThreads)
+{
+    FILE *fd = fopen(nomFichier, "r");
+    myassert(fd != NULL, "probleme ouverture fichier lecture");
+    Collection c = col_creer();
+    double debut = secondes();
+    col_lireFichierParallele(c, fd, nbThreads);
+    double duree = secondes() - debut;
+    fclose(fd);
+    col_detruire(&c);
+    return duree;
+}
+
+void testFormats()
+{
+    printf("\n");
+    printf("=============================================================\n");
+    printf("= Formats de fichier \n");
+    printf("=============================================================\n");
+    printf("\n");
+
+    const char * marques[] = {"Trombine", "Loopile", "Ondine", "Pixile", "Cosmosine"};
+    const char * plaques[] = {"ZA 123 AZ", "1234 AE 75"};
+    char plaque[MAX_LEN+1];
+    const char *tmp[1] = {plaque};
+
+    Collection c = col_creer();
+    for (int i = 0; i < NB_VOITURES_FORMATS; i++)
+    {
+        // années triées, une immatriculation récente et parfois une ancienne
+        sprintf(plaque, "%c%c %03d %c%c", 'A' + i % 26, 'A' + (i / 26) % 26, i % 1000,
+                'A' + (i / 676) % 26, 'A' + (i / 17576) % 26);
+        Voiture v = voi_creer(marques[i % 5], 1950 + i * 70 / NB_VOITURES_FORMATS, i % 300000,
+                              1, i % 3 == 0 ? plaques + 1 : tmp);
+        col_addVoitureSansTri(c, v);
+        voi_detruire(&v);
+    }
+
+    ecrireFormat(c, "formats_test.save", false);
+    ecrireFormat(c, "formats_test.savez", true);
+
+    FILE *fd = fopen("formats_test.saveb", "w");
+    myassert(fd != NULL, "probleme ouverture fichier écriture");
+    col_ecrireFichierParallele(c, fd, 4);
+    fclose(fd);
+
+    fd = fopen("formats_test.csv", "w");
+    myassert(fd != NULL, "probleme ouverture fichier écriture");
+    col_exporterCSV(c, fd);
+    long tailleCSV = ftell(fd);
+    fclose(fd);
+
+    // une voiture sur deux est supprimée puis la collection est compactée
+    int compteur = 0;
+    ColMemoire avant = col_getMemoryUsage(c);
+    col_supprimerSi(c, voitureImpaire, &compteur);
+    ColMemoire apresSuppression = col_getMemoryUsage(c);
+    col_compacter(c);
+    ColMemoire apresCompactage = col_getMemoryUsage(c);
+    col_detruire(&c);
+
+    fd = fopen("formats_test.csv", "r");
+    myassert(fd != NULL, "probleme ouverture fichier lecture");
+    c = col_creer();
+    clock_t debut = clock();
+    col_importerCSV(c, fd);
+    double dureeCSV = (double)(clock() - debut) / CLOCKS_PER_SEC;
+    fclose(fd);
+    col_detruire(&c);
+
+    double dureeBrut, dureeCompresse;
+    long tailleBrut = lireFormat("formats_test.save", &dureeBrut);
+    long tailleCompresse = lireFormat("formats_test.savez", &dureeCompresse);
+
+    printf("%d voitures\n", NB_VOITURES_FORMATS);
+    printf("  brut      : %ld octets, lu en %.3f s\n", tailleBrut, dureeBrut);
+    printf("  compressé : %ld octets, lu en %.3f s\n", tailleCompresse, dureeCompresse);
+    printf("  ratio     : %.2f\n", (double)tailleBrut / tailleCompresse);
+    printf("  CSV       : %ld octets, importé en %.3f s (%.1f Mo/s)\n",
+           tailleCSV, dureeCSV, tailleCSV / 1e6 / dureeCSV);
+    printf("  par blocs : lu en");
+    for (int nbThreads = 1; nbThreads <= 4; nbThreads *= 2)
+        printf(" %.3f s (%d thread%s)", lireFormatParallele("formats_test.saveb", nbThreads),
+               nbThreads, nbThreads > 1 ? "s" : "");
+    printf("\n");
+
+    printf("\nMémoire\n");
+    afficherMemoire("initiale", avant);
+    afficherMemoire("après suppressions", apresSuppression);
+    afficherMemoire("après compactage", apresCompactage);
+}
+
+
+/*=================================================================*
+ * Test différentiel : collections comparées à un modèle tableau
+ * (suites aléatoires d'opérations, reproductibles par la graine)
+ *=================================================================*/
+#define NB_COLLECTIONS_STRESS 3
+#define MAX_VOITURES_STRESS 128
+#define NB_SEQUENCES_STRESS 200
+#define NB_OPERATIONS_STRESS 400
+
+// Modèle de référence : les voitures dans l'ordre attendu de la collection
+typedef struct
+{
+    Voiture voitures[2 * MAX_VOITURES_STRESS];
+    int nb;
+} Modele;
+
+static void modele_vider(Modele *m)
+{
+    for (int i = 0; i < m->nb; i++)
+        voi_detruire(&(m->voitures[i]));
+    m->nb = 0;
+}
+
+static void modele_inserer(Modele *m, int pos, const_Voiture v)
+{
+    myassert(m->nb < 2 * MAX_VOITURES_STRESS, "modele_inserer - Model is full");
+    for (int i = m->nb; i > pos; i--)
+        m->voitures[i] = m->voitures[i-1];
+    m->voitures[pos] = voi_creerCopie(v);
+    m->nb++;
+}
+
+static void modele_supprimer(Modele *m, int pos)
+{
+    voi_detruire(&(m->voitures[pos]));
+    for (int i = pos; i < m->nb - 1; i++)
+        m->voitures[i] = m->voitures[i+1];
+    m->nb--;
+}
+
+static void modele_copier(Modele *destination, const Modele *source)
+{
+    modele_vider(destination);
+    for (int i = 0; i < source->nb; i++)
+        destination->voitures[i] = voi_creerCopie(source->voitures[i]);
+    destination->nb = source->nb;
+}
+
+// tri par insertion, stable comme col_trier
+static void modele_trier(Modele *m)
+{
+    for (int i = 1; i < m->nb; i++)
+    {
+        Voiture v = m->voitures[i];
+        int j = i;
+        for ( ; j > 0 && voi_getAnnee(m->voitures[j-1]) > voi_getAnnee(v); j--)
+            m->voitures[j] = m->voitures[j-1];
+        m->voitures[j] = v;
+    }
+}
+
+// première position dont l'année dépasse celle de v (m étant trié)
+static int modele_positionTriee(const Modele *m, const_Voiture v)
+{
+    int pos = 0;
+    while (pos < m->nb && voi_getAnnee(m->voitures[pos]) <= voi_getAnnee(v))
+        pos++;
+    return pos;
+}
+
+static bool voitures_egales(const_Voiture v1, const_Voiture v2)
+{
+    char s1[MAX_LEN+1], s2[MAX_LEN+1];
+    voi_getMarque(v1, s1);
+    voi_getMarque(v2, s2);
+    if (strcmp(s1, s2) != 0 || voi_getAnnee(v1) != voi_getAnnee(v2)
+        || voi_getKilometrage(v1) != voi_getKilometrage(v2)
+        || voi_getNbImmatriculations(v1) != voi_getNbImmatriculations(v2))
+        return false;
+    for (int i = 0; i < voi_getNbImmatriculations(v1); i++)
+    {
+        voi_getImmatriculation(v1, i, s1);
+        voi_getImmatriculation(v2, i, s2);
+        if (strcmp(s1, s2) != 0)
+            return false;
+    }
+    return true;
+}
+
+// compare le contenu et les statistiques de c avec le modèle
+static bool stress_verifier(const_Collection c, const Modele *m)
+{
+    if (col_getNbVoitures(c) != m->nb)
+        return false;
+
+    long long kilometrage = 0;
+    for (int i = 0; i < m->nb; i++)
+    {
+        Voiture v = col_getVoiture(c, i);
+        bool egales = voitures_egales(v, m->voitures[i]);
+        voi_detruire(&v);
+        if (!egales)
+            return false;
+        kilometrage += voi_getKilometrage(m->voitures[i]);
+    }
+    if (col_stat_getKilometrageTotal(c) != kilometrage)
+        return false;
+
+    ColMemoire memoire = col_getMemoryUsage(c);
+    if ((m->nb > 0) != (memoire.elements > 0) || (m->nb > 0) != (memoire.voitures > 0))
+        return false;
+
+    if (m->nb > 0)
+    {
+        const_Voiture v = m->voitures[rand() % m->nb];
+        char marque[MAX_LEN+1];
+        int nbAnnee = 0, nbMarque = 0, anneeMin = voi_getAnnee(v), anneeMax = voi_getAnnee(v);
+        voi_getMarque(v, marque);
+        for (int i = 0; i < m->nb; i++)
+        {
+            char tmp[MAX_LEN+1];
+            voi_getMarque(m->voitures[i], tmp);
+            nbAnnee += voi_getAnnee(m->voitures[i]) == voi_getAnnee(v);
+            nbMarque += strcmp(tmp, marque) == 0;
+            if (voi_getAnnee(m->voitures[i]) < anneeMin)
+                anneeMin = voi_getAnnee(m->voitures[i]);
+            if (voi_getAnnee(m->voitures[i]) > anneeMax)
+                anneeMax = voi_getAnnee(m->voitures[i]);
+        }
+        if (col_stat_getAnneeMin(c) != anneeMin || col_stat_getAnneeMax(c) != anneeMax
+            || col_stat_getNbVoituresAnnee(c, voi_getAnnee(v)) != nbAnnee
+            || col_stat_getNbVoituresMarque(c, marque) != nbMarque)
+            return false;
+    }
+    return true;
+}
+
+static int comparerEntiers(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static int voiture_cle(const_Voiture v, ColCle cle)
+{
+    return cle == COL_CLE_ANNEE ? voi_getAnnee(v) : voi_getKilometrage(v);
+}
+
+// compare col_percentile et col_topK aux clés triées du modèle
+static bool stress_verifierOrdre(const_Collection c, const Modele *m, ColCle cle)
+{
+    int cles[2 * MAX_VOITURES_STRESS];
+    for (int i = 0; i < m->nb; i++)
+        cles[i] = voiture_cle(m->voitures[i], cle);
+    qsort(cles, m->nb, sizeof(int), comparerEntiers);
+
+    const double p[] = {0, 1, 25, 50, 90, 99.9, 100};
+    for (int i = 0; m->nb > 0 && i < (int)(sizeof(p) / sizeof(p[0])); i++)
+    {
+        // rang le plus proche : plafond(p / 100 * n), au moins 1
+        double rangReel = p[i] / 100 * m->nb;
+        int rang = (int)rangReel;
+        if (rang < rangReel)
+            rang++;
+        if (col_percentile(c, cle, p[i]) != cles[rang > 0 ? rang - 1 : 0])
+            return false;
+    }
+
+    // k nul, k quelconque et k plus grand que la collection
+    Voiture out[2 * MAX_VOITURES_STRESS + 2];
+    const int ks[] = {0, rand() % (m->nb + 1), m->nb + 2};
+    for (int i = 0; i < 3; i++)
+    {
+        int n = col_topK(c, cle, ks[i], out);
+        bool estCorrect = (n == (ks[i] < m->nb ? ks[i] : m->nb));
+        for (int j = 0; j < n; j++)
+        {
+            // chaque voiture rendue doit être l'une de celles du modèle
+            bool estTrouvee = false;
+            for (int k = 0; k < m->nb && !estTrouvee; k++)
+                estTrouvee = voitures_egales(out[j], m->voitures[k]);
+            estCorrect = estCorrect && estTrouvee && voiture_cle(out[j], cle) == cles[m->nb - 1 - j];
+            voi_detruire(&out[j]);
+        }
+        if (!estCorrect)
+            return false;
+    }
+    return true;
+}
+
+static Voiture stress_creerVoiture()
+{
+    // peu d'années différentes pour avoir des égalités, des marques à échapper en CSV
+    const char *marques[] = {"Trombine", "Loopile", "Pixi,le", "On\"dine", "Cosmo\nsine"};
+    const char *plaques[] = {"ZA 123 AZ", "1234 AE 75", "VH 529 FE", "AB-000-CD"};
+    if (rand() % 50 == 0)
+    {
+        // marque et immatriculation de la longueur maximale acceptée par les formats
+        char longue[MAX_LEN+1];
+        memset(longue, 'L', MAX_LEN);
+        longue[MAX_LEN] = '\0';
+        const char *immatriculations[] = {plaques[0], longue};
+        return voi_creer(longue, 1990 + rand() % 12, rand() % 100000, 2, immatriculations);
+    }
+    return voi_creer(marques[rand() % 5], 1990 + rand() % 12, rand() % 100000,
+                     rand() % 4, plaques + rand() % 2);
+}
+
+static bool stress_predicat(const_Voiture v, void *ctx)
+{
+    return voi_getAnnee(v) < *(int *)ctx;
+}
+
+// sauvegarde puis relit c dans un format tiré au hasard
+static void stress_sauverRelire(Collection *pc)
+{
+    FILE *fd = tmpfile();
+    myassert(fd != NULL, "probleme ouverture fichier temporaire");
+    Collection lue = col_creer();
+    switch (rand() % 4)
+    {
+        case 0:
+            col_ecrireFichier(*pc, fd);
+            col_lireFichier(lue, fd);
+            break;
+        case 1:
+            col_ecrireFichierCompresse(*pc, fd);
+            col_lireFichier(lue, fd);
+            break;
+        case 2:
+            col_ecrireFichierParallele(*pc, fd, 1 + rand() % 4);
+            col_lireFichierParallele(lue, fd, 1 + rand() % 4);
+            break;
+        default:
+            col_exporterCSV(*pc, fd);
+            rewind(fd);
+            col_importerCSV(lue, fd);
+            break;
+    }
+    fclose(fd);
+    col_detruire(pc);
+    *pc = lue;
+}
+
+// vrai si l'immatriculation actuelle (la dernière) de v est aussi celle d'une voiture de autre,
+// faux pour une voiture sans immatriculation
+static bool modele_immatriculationCommune(const_Voiture v, const Modele *autre)
+{
+    int nb = voi_getNbImmatriculations(v);
+    if (nb == 0)
+        return false;
+    char immatriculation[MAX_LEN+1], tmp[MAX_LEN+1];
+    voi_getImmatriculation(v, nb - 1, immatriculation);
+    for (int i = 0; i < autre->nb; i++)
+    {
+        int nbAutre = voi_getNbImmatriculations(autre->voitures[i]);
+        if (nbAutre == 0)
+            continue;
+        voi_getImmatriculation(autre->voitures[i], nbAutre - 1, tmp);
+        if (strcmp(tmp, immatriculation) == 0)
+            return true;
+    }
+    return false;
+}
+
+// remplace c[i] par sa différence ou son intersection avec c[j] (éventuellement c[i] elle-même)
+static const char *stress_filtrerImmatriculations(Collection c[], Modele m[], int i, int j)
+{
+    static Modele resultat;
+    bool garderCommunes = rand() % 2;
+    Collection filtree = garderCommunes ? col_intersection(c[i], c[j]) : col_difference(c[i], c[j]);
+    for (int k = 0; k < m[i].nb; k++)
+        if (modele_immatriculationCommune(m[i].voitures[k], &m[j]) == garderCommunes)
+            modele_inserer(&resultat, resultat.nb, m[i].voitures[k]);
+
+    col_detruire(&c[i]);
+    c[i] = filtree;
+    modele_copier(&m[i], &resultat);
+    modele_vider(&resultat);
+    return garderCommunes ? "col_intersection" : "col_difference";
+}
+
+// lance une sauvegarde asynchrone de c, modifie c pendant l'écriture, puis vérifie
+// que le fichier relu contient la collection telle qu'elle était au lancement
+static bool stress_sauverPendantModification(Collection c, Modele *m)
+{
+    static Modele instantane;
+    modele_copier(&instantane, m);
+
+    FILE *fd = tmpfile();
+    myassert(fd != NULL, "probleme ouverture fichier temporaire");
+    Sauvegarde sauvegarde = col_ecrireFichierAsync(c, fd);
+
+    if (m->nb > 0)
+    {
+        int pos = rand() % m->nb;
+        col_supprVoitureSansTri(c, pos);
+        modele_supprimer(m, pos);
+    }
+    if (m->nb > 0)
+    {
+        int pos = rand() % m->nb;
+        int kilometrage = voi_getKilometrage(m->voitures[pos]) + 1 + rand() % 1000;
+        col_setKilometrage(c, pos, kilometrage);
+        voi_setKilometrage(m->voitures[pos], kilometrage);
+    }
+    col_trier(c);
+    modele_trier(m);
+    col_compacter(c);
+
+    col_attendreSauvegarde(&sauvegarde);
+    Collection lue = col_creer();
+    col_lireFichier(lue, fd);
+    fclose(fd);
+    bool estCorrecte = stress_verifier(lue, &instantane);
+    col_detruire(&lue);
+    modele_vider(&instantane);
+    return estCorrecte;
+}
+
+// applique une opération tirée au hasard à la fois aux collections et aux modèles
+// retourne son nom, ou NULL si une requête ou une sauvegarde n'a pas rendu le résultat du modèle
+static const char *stress_operation(Collection c[], Modele m[])
+{
+    int i = rand() % NB_COLLECTIONS_STRESS;
+    int j = (i + 1 + rand() % (NB_COLLECTIONS_STRESS - 1)) % NB_COLLECTIONS_STRESS;
+    Voiture v;
+
+    // les collections trop grandes sont réduites, et une fusion ou une concaténation
+    // ne doit pas dépasser la capacité du modèle
+    int operation = m[i].nb >= MAX_VOITURES_STRESS ? 7 : rand() % 17;
+    if ((operation == 9 || operation == 10) && m[i].nb + m[j].nb > 2 * MAX_VOITURES_STRESS)
+        operation = 7;
+    switch (operation)
+    {
+        case 0:
+        case 1:
+            v = stress_creerVoiture();
+            col_addVoitureSansTri(c[i], v);
+            modele_inserer(&m[i], m[i].nb, v);
+            voi_detruire(&v);
+            return "col_addVoitureSansTri";
+        case 2:
+            v = stress_creerVoiture();
+            col_addVoitureAvecTri(c[i], v);
+            modele_trier(&m[i]);
+            modele_inserer(&m[i], modele_positionTriee(&m[i], v), v);
+            voi_detruire(&v);
+            return "col_addVoitureAvecTri";
+        case 3:
+            if (m[i].nb == 0)
+                return "rien";
+            {
+                int pos = rand() % m[i].nb;
+                col_supprVoitureSansTri(c[i], pos);
+                modele_supprimer(&m[i], pos);
+            }
+            return "col_supprVoitureSansTri";
+        case 4:
+            col_trier(c[i]);
+            modele_trier(&m[i]);
+            return "col_trier";
+        case 5:
+            col_detruire(&c[j]);
+            c[j] = col_creerCopie(c[i]);
+            modele_vider(&m[j]);
+            for (int k = 0; k < m[i].nb; k++)
+                modele_inserer(&m[j], k, m[i].voitures[k]);
+            return "col_creerCopie";
+        case 6:
+            if (m[i].nb == 0)
+                return "rien";
+            {
+                int pos = rand() % m[i].nb;
+                int kilometrage = voi_getKilometrage(m[i].voitures[pos]) + rand() % 1000;
+                col_setKilometrage(c[i], pos, kilometrage);
+                voi_setKilometrage(m[i].voitures[pos], kilometrage);
+            }
+            return "col_setKilometrage";
+        case 7:
+            {
+                int seuil = 1990 + rand() % 12;
+                col_supprimerSi(c[i], stress_predicat, &seuil);
+                for (int k = m[i].nb - 1; k >= 0; k--)
+                    if (voi_getAnnee(m[i].voitures[k]) < seuil)
+                        modele_supprimer(&m[i], k);
+            }
+            return "col_supprimerSi";
+        case 8:
+            if (m[i].nb == 0)
+                return "rien";
+            {
+                int positions[8];
+                int n = 1 + rand() % 8;
+                bool aSupprimer[2 * MAX_VOITURES_STRESS] = {false};
+                for (int k = 0; k < n; k++)
+                {
+                    positions[k] = rand() % m[i].nb;
+                    aSupprimer[positions[k]] = true;
+                }
+                col_supprimerPositions(c[i], positions, n);
+                for (int k = m[i].nb - 1; k >= 0; k--)
+                    if (aSupprimer[k])
+                        modele_supprimer(&m[i], k);
+            }
+            return "col_supprimerPositions";
+        case 9:
+            {
+                bool deplacer = rand() % 2;
+                col_fusionner(c[i], c[j], deplacer);
+                modele_trier(&m[i]);
+                modele_trier(&m[j]);
+                for (int k = 0; k < m[j].nb; k++)
+                    modele_inserer(&m[i], modele_positionTriee(&m[i], m[j].voitures[k]), m[j].voitures[k]);
+                if (deplacer)
+                    modele_vider(&m[j]);
+            }
+            return "col_fusionner";
+        case 10:
+            col_concatener(c[i], c[j]);
+            for (int k = 0; k < m[j].nb; k++)
+                modele_inserer(&m[i], m[i].nb, m[j].voitures[k]);
+            modele_vider(&m[j]);
+            return "col_concatener";
+        case 11:
+            col_vider(c[i]);
+            modele_vider(&m[i]);
+            return "col_vider";
+        case 12:
+            col_compacter(c[i]);
+            return "col_compacter";
+        case 13:
+            // sur une collection triée (lecture directe par année) ou non (sélection)
+            if (rand() % 2)
+            {
+                col_trier(c[i]);
+                modele_trier(&m[i]);
+            }
+            if (!stress_verifierOrdre(c[i], &m[i], COL_CLE_ANNEE)
+                || !stress_verifierOrdre(c[i], &m[i], COL_CLE_KILOMETRAGE))
+                return NULL;
+            return "col_percentile et col_topK";
+        case 14:
+            if (!stress_sauverPendantModification(c[i], &m[i]))
+                return NULL;
+            return "col_ecrireFichierAsync";
+        case 15:
+            return stress_filtrerImmatriculations(c, m, i, rand() % 4 == 0 ? i : j);
+        default:
+            stress_sauverRelire(&c[i]);
+            return "sauvegarde et relecture";
+    }
+}
+
+void testStress()
+{
+    printf("\n");
+    printf("=============================================================\n");
+    printf("= Test différentiel \n");
+    printf("=============================================================\n");
+    printf("\n");
+
+    static Modele modeles[NB_COLLECTIONS_STRESS];
+    Collection collections[NB_COLLECTIONS_STRESS];
+
+    for (int graine = 1; graine <= NB_SEQUENCES_STRESS; graine++)
+    {
+        srand(graine);
+        for (int i = 0; i < NB_COLLECTIONS_STRESS; i++)
+            collections[i] = col_creer();
+
+        for (int n = 0; n < NB_OPERATIONS_STRESS; n++)
+        {
+            const char *operation = stress_operation(collections, modeles);
+            if (operation == NULL)
+            {
+                printf("divergence : graine %d, opération %d (col_percentile, col_topK ou col_ecrireFichierAsync)\n", graine, n);
+                exit(EXIT_FAILURE);
+            }
+            for (int i = 0; i < NB_COLLECTIONS_STRESS; i++)
+            {
+                if (!stress_verifier(collections[i], &modeles[i]))
+                {
+                    printf("divergence : graine %d, opération %d (%s), collection %d\n",
+                           graine, n, operation, i);
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+
+        for (int i = 0; i < NB_COLLECTIONS_STRESS; i++)
+        {
+            col_detruire(&collections[i]);
+            modele_vider(&modeles[i]);
+        }
+    }
+    printf("%d suites de %d opérations, aucune divergence\n", NB_SEQUENCES_STRESS, NB_OPERATIONS_STRESS);
+}
+
+
+/*=================================================================*
+ * Test différentiel de la collection persistante : chaque version
+ * conservée doit garder le contenu de son modèle, quelles que soient
+ * les versions dérivées ensuite
+ *=================================================================*/
+#define NB_VERSIONS_PERSISTANTE 8
+#define NB_SEQUENCES_PERSISTANTE 50
+#define NB_OPERATIONS_PERSISTANTE 100
+
+// compare la version, et la collection qui en est tirée, avec le modèle (trié)
+static bool persistante_verifier(const_ColPersistante v, const Modele *m)
+{
+    if (colp_getNbVoitures(v) != m->nb)
+        return false;
+    int anneePrecedente = INT_MIN;
+    for (int i = 0; i < m->nb; i++)
+    {
+        Voiture voiture = colp_getVoiture(v, i);
+        bool estCorrecte = voi_getAnnee(voiture) >= anneePrecedente && voitures_egales(voiture, m->voitures[i]);
+        anneePrecedente = voi_getAnnee(voiture);
+        voi_detruire(&voiture);
+        if (!estCorrecte)
+            return false;
+    }
+
+    Collection c = colp_versCollection(v);
+    bool estCorrecte = stress_verifier(c, m);
+    col_detruire(&c);
+    return estCorrecte;
+}
+
+void testPersistante()
+{
+    static Modele modeles[NB_VERSIONS_PERSISTANTE];
+    ColPersistante versions[NB_VERSIONS_PERSISTANTE];
+
+    for (int graine = 1; graine <= NB_SEQUENCES_PERSISTANTE; graine++)
+    {
+        srand(graine);
+
+        // première version construite depuis une collection non triée
+        Collection c = col_creer();
+        for (int n = rand() % MAX_VOITURES_STRESS; n > 0; n--)
+        {
+            Voiture voiture = stress_creerVoiture();
+            col_addVoitureSansTri(c, voiture);
+            modele_inserer(&modeles[0], modeles[0].nb, voiture);
+            voi_detruire(&voiture);
+        }
+        if (rand() % 2)
+            col_trier(c);
+        modele_trier(&modeles[0]);
+        versions[0] = colp_creerDepuisCollection(c);
+        col_detruire(&c);
+        for (int i = 1; i < NB_VERSIONS_PERSISTANTE; i++)
+        {
+            versions[i] = colp_creer();
+            modele_vider(&modeles[i]);
+        }
+
+        for (int n = 0; n < NB_OPERATIONS_PERSISTANTE; n++)
+        {
+            // la version i est dérivée de la version j, qui est conservée
+            int j = rand() % NB_VERSIONS_PERSISTANTE;
+            int i = (j + 1 + rand() % (NB_VERSIONS_PERSISTANTE - 1)) % NB_VERSIONS_PERSISTANTE;
+            ColPersistante nouvelle;
+            const char *operation;
+            if (modeles[j].nb > 0 && (modeles[j].nb >= MAX_VOITURES_STRESS || rand() % 3 == 0))
+            {
+                int pos = rand() % modeles[j].nb;
+                nouvelle = colp_supprVoiture(versions[j], pos);
+                modele_copier(&modeles[i], &modeles[j]);
+                modele_supprimer(&modeles[i], pos);
+                operation = "colp_supprVoiture";
+            }
+            else
+            {
+                Voiture voiture = stress_creerVoiture();
+                nouvelle = colp_addVoiture(versions[j], voiture);
+                modele_copier(&modeles[i], &modeles[j]);
+                modele_inserer(&modeles[i], modele_positionTriee(&modeles[i], voiture), voiture);
+                voi_detruire(&voiture);
+                operation = "colp_addVoiture";
+            }
+            colp_detruire(&versions[i]);
+            versions[i] = nouvelle;
+
+            for (int k = 0; k < NB_VERSIONS_PERSISTANTE; k++)
+            {
+                if (!persistante_verifier(versions[k], &modeles[k]))
+                {
+                    printf("divergence : graine %d, opération %d (%s), version %d\n",
+                           graine, n, operation, k);
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+
+        for (int i = 0; i < NB_VERSIONS_PERSISTANTE; i++)
+        {
+            colp_detruire(&versions[i]);
+            modele_vider(&modeles[i]);
+        }
+    }
+    printf("%d suites de %d versions dérivées, aucune divergence\n",
+           NB_SEQUENCES_PERSISTANTE, NB_OPERATIONS_PERSISTANTE);
+}
+
+
+/*=================================================================*
+ * Lecture d'un fichier quelconque (point d'entrée pour un fuzzer)
+ *=================================================================*/
+void testLecture(const char *nomFichier)
+{
+    FILE *fd = fopen(nomFichier, "r");
+    myassert(fd != NULL, "probleme ouverture fichier lecture");
+    Collection c = col_creer();
+    col_lireFichier(c, fd);
+    fclose(fd);
+
+    // la collection lue doit rester utilisable
+    Collection copie = col_creerCopie(c);
+    col_trier(copie);
+    printf("%d voitures lues\n", col_getNbVoitures(c));
+    col_detruire(&copie);
+    col_detruire(&c);
+}
+
+
 /*=================================================================*
  * Programme principal
  *=================================================================*/
 int main(int argc, char *argv[])
 {
+    if ((argc == 3) && (strcmp(argv[1], "lire") == 0))
+    {
+        testLecture(argv[2]);
+        return EXIT_SUCCESS;
+    }
     if (argc > 2)
         usage(argv[0]);
+    else if ((argc == 2) && (strcmp(argv[1], "stress") == 0))
+    {
+        testStress();
+        testPersistante();
+        return EXIT_SUCCESS;
+    }
     else if ((argc == 2) && (strcmp(argv[1], "full") != 0))
         usage(argv[0]);
 
@@ -262,6 +1065,8 @@ int main(int argc, char *argv[])
     testVoitures(argc == 2);
     testCollections(argc == 2);
     testStatistiques();
+    if (argc == 2)
+        testFormats();
 
     return EXIT_SUCCESS;
 }